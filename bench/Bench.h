@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define HD_HAPTICS_BENCH_CYCLE_COUNTER
+#elif defined(_M_X64) || defined(_M_IX86)
+    #include <intrin.h>
+    #define HD_HAPTICS_BENCH_CYCLE_COUNTER
+#endif
+
+namespace hd_haptics::bench {
+    struct Options {
+        /// How long the benchmarks that run against the wall clock take.
+        double realtime_seconds = 3.0;
+    };
+
+    /// Prints its results and returns false if a correctness check failed.
+    using Benchmark = bool (*)(const Options& options);
+
+    /// `_process` → ring buffer → device callback, against a simulated and a real-time device clock.
+    bool run_pipeline_benchmark(const Options& options);
+
+    /// ChannelConverter against ma_channel_converter for the DualSense layout.
+    bool run_channel_converter_benchmark(const Options& options);
+
+    /// Cost of every HapticsConditioner stage against the length of a mix block.
+    bool run_conditioner_benchmark(const Options& options);
+
+    /// The resampler tiers of the DriftCompensator against ma_resampler.
+    bool run_resampler_benchmark(const Options& options);
+
+    /// Nanoseconds elapsed since `start`.
+    inline double get_elapsed_ns(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /// Keeps the compiler from optimizing away a result that is otherwise unused.
+    inline void do_not_optimize(const void* p_value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "g"(p_value) : "memory");
+#else
+        static const void* volatile sink;
+        sink = p_value;
+#endif
+    }
+
+    /// Cost of one call, in nanoseconds and in time stamp counter cycles. Cycles are 0 where there is no counter.
+    struct Measurement {
+        double ns = 0.0;
+        double cycles = 0.0;
+    };
+
+    inline uint64_t read_cycle_counter() {
+#if defined(HD_HAPTICS_BENCH_CYCLE_COUNTER)
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    /// Calls `function` repeatedly for about `duration`, after warming up for a tenth of it.
+    template <typename Function>
+    Measurement measure(Function&& function, std::chrono::milliseconds duration = std::chrono::milliseconds(300)) {
+        constexpr int CALLS_PER_BATCH = 16;
+
+        const auto warm_up_end = std::chrono::steady_clock::now() + duration / 10;
+        while (std::chrono::steady_clock::now() < warm_up_end) {
+            function();
+        }
+
+        uint64_t calls = 0;
+        const uint64_t start_cycles = read_cycle_counter();
+        const auto start = std::chrono::steady_clock::now();
+
+        while (std::chrono::steady_clock::now() - start < duration) {
+            for (int call = 0; call < CALLS_PER_BATCH; ++call) {
+                function();
+            }
+
+            calls += CALLS_PER_BATCH;
+        }
+
+        const double elapsed_ns = get_elapsed_ns(start);
+        const uint64_t elapsed_cycles = read_cycle_counter() - start_cycles;
+
+        return {elapsed_ns / static_cast<double>(calls), static_cast<double>(elapsed_cycles) / static_cast<double>(calls)};
+    }
+} // namespace hd_haptics::bench
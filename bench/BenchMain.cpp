@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Bench.h"
+
+using namespace hd_haptics::bench;
+
+namespace {
+    constexpr std::array<std::pair<std::string_view, Benchmark>, 4> BENCHMARKS = {{
+        {"pipeline", run_pipeline_benchmark},
+        {"channel_converter", run_channel_converter_benchmark},
+        {"conditioner", run_conditioner_benchmark},
+        {"resampler", run_resampler_benchmark},
+    }};
+
+    void print_usage() {
+        std::printf("Usage: haptics_bench [--realtime-seconds <seconds>] [benchmark...]\n\nBenchmarks:");
+        for (const auto& [name, benchmark] : BENCHMARKS) {
+            std::printf(" %.*s", static_cast<int>(name.size()), name.data());
+        }
+        std::printf("\n");
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    std::vector<std::string_view> selected;
+
+    for (int i_arg = 1; i_arg < argc; ++i_arg) {
+        const std::string_view arg = argv[i_arg];
+
+        if (arg == "--realtime-seconds" && i_arg + 1 < argc) {
+            options.realtime_seconds = std::atof(argv[++i_arg]);
+        } else if (arg.starts_with("-")) {
+            print_usage();
+            return arg == "--help" || arg == "-h" ? EXIT_SUCCESS : EXIT_FAILURE;
+        } else {
+            selected.push_back(arg);
+        }
+    }
+
+    bool passed = true;
+
+    for (const auto& [name, benchmark] : BENCHMARKS) {
+        if (!selected.empty() && std::ranges::find(selected, name) == selected.end()) {
+            continue;
+        }
+
+        std::printf("== %.*s ==\n", static_cast<int>(name.size()), name.data());
+        passed = benchmark(options) && passed;
+        std::printf("\n");
+    }
+
+    if (!passed) {
+        std::printf("FAILED: at least one correctness check did not pass\n");
+    }
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
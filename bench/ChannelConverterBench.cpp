@@ -0,0 +1,100 @@
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "Bench.h"
+#include "HapticsRenderer.h"
+#include "external/miniaudio_init.h"
+
+namespace hd_haptics::bench {
+    namespace {
+        constexpr uint32_t BLOCK_FRAMES = 512;
+
+        using Converter = HapticsRenderer::Converter;
+        constexpr int INPUT_CHANNELS = HapticsRenderer::INPUT_CHANNELS;
+        constexpr int OUTPUT_CHANNELS = HapticsRenderer::OUTPUT_CHANNELS;
+
+        const char* get_kernel_name() {
+#if defined(HD_HAPTICS_SIMD_AVX)
+            return "AVX";
+#elif defined(HD_HAPTICS_SIMD_SSE2)
+            return "SSE2";
+#elif defined(HD_HAPTICS_SIMD_NEON)
+            return "NEON";
+#else
+            return "scalar";
+#endif
+        }
+
+        void print_row(const char* name, const Measurement& measurement) {
+            std::printf("%-40s %10.2f", name, measurement.ns / BLOCK_FRAMES);
+
+            if (measurement.cycles > 0.0) {
+                std::printf(" %12.2f\n", measurement.cycles / BLOCK_FRAMES);
+            } else {
+                std::printf(" %12s\n", "n/a");
+            }
+        }
+    } // namespace
+
+    bool run_channel_converter_benchmark(const Options&) {
+        std::vector<float> input(static_cast<size_t>(BLOCK_FRAMES) * INPUT_CHANNELS);
+        for (size_t sample = 0; sample < input.size(); ++sample) {
+            input[sample] = std::sin(static_cast<float>(sample) * 0.01f);
+        }
+
+        std::vector<float> output(static_cast<size_t>(BLOCK_FRAMES) * OUTPUT_CHANNELS);
+        std::vector<float> reference(output.size());
+
+        // The configuration the devices used before ChannelConverter
+        constexpr ma_channel input_map[INPUT_CHANNELS] = {MA_CHANNEL_BACK_LEFT, MA_CHANNEL_BACK_RIGHT};
+        constexpr ma_channel output_map[OUTPUT_CHANNELS] = {MA_CHANNEL_FRONT_LEFT, MA_CHANNEL_FRONT_RIGHT, MA_CHANNEL_BACK_LEFT, MA_CHANNEL_BACK_RIGHT};
+        const ma_channel_converter_config config =
+            ma_channel_converter_config_init(ma_format_f32, INPUT_CHANNELS, input_map, OUTPUT_CHANNELS, output_map, ma_channel_mix_mode_simple);
+
+        ma_channel_converter converter;
+        if (ma_channel_converter_init(&config, nullptr, &converter) != MA_SUCCESS) {
+            std::printf("ma_channel_converter_init failed\n");
+            return false;
+        }
+
+        // Both must produce the same frames before their speed is worth comparing
+        ma_channel_converter_process_pcm_frames(&converter, reference.data(), input.data(), BLOCK_FRAMES);
+        Converter::process(output.data(), input.data(), BLOCK_FRAMES);
+        bool passed = output == reference;
+
+        const Converter::Gains gains = {0.5f, 2.0f};
+        Converter::process(output.data(), input.data(), BLOCK_FRAMES, gains);
+        for (uint32_t frame = 0; frame < BLOCK_FRAMES; ++frame) {
+            for (int channel = 0; channel < INPUT_CHANNELS; ++channel) {
+                const float expected = input[frame * INPUT_CHANNELS + channel] * gains[channel];
+                passed = passed && output[frame * OUTPUT_CHANNELS + channel] == 0.0f && output[frame * OUTPUT_CHANNELS + 2 + channel] == expected;
+            }
+        }
+
+        std::printf("stereo -> quad back pair, %u frame blocks, %s kernel\n\n", BLOCK_FRAMES, get_kernel_name());
+        std::printf("%-40s %10s %12s\n", "converter", "ns/frame", "cycles/frame");
+
+        const Measurement plain = measure([&] {
+            Converter::process(output.data(), input.data(), BLOCK_FRAMES);
+            do_not_optimize(output.data());
+        });
+        const Measurement with_gains = measure([&] {
+            Converter::process(output.data(), input.data(), BLOCK_FRAMES, gains);
+            do_not_optimize(output.data());
+        });
+        const Measurement miniaudio = measure([&] {
+            ma_channel_converter_process_pcm_frames(&converter, output.data(), input.data(), BLOCK_FRAMES);
+            do_not_optimize(output.data());
+        });
+
+        print_row("ChannelConverter", plain);
+        print_row("ChannelConverter with gains", with_gains);
+        print_row("ma_channel_converter (simple)", miniaudio);
+
+        ma_channel_converter_uninit(&converter, nullptr);
+
+        std::printf("output matches ma_channel_converter: %s\n", passed ? "ok" : "FAILED");
+        return passed;
+    }
+} // namespace hd_haptics::bench
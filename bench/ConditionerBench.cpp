@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <numbers>
+#include <vector>
+
+#include "Bench.h"
+#include "HapticsConditioner.h"
+
+namespace hd_haptics::bench {
+    namespace {
+        // One Godot mix block at the default mix rate
+        constexpr uint32_t SAMPLE_RATE = 44100;
+        constexpr uint32_t BLOCK_FRAMES = 512;
+        constexpr int CHANNELS = HapticsConditioner::CHANNELS;
+
+        // Blocks processed before checking the output, so the filters and the compressor have settled
+        constexpr int SETTLING_BLOCKS = 200;
+
+        using Settings = HapticsConditioner::Settings;
+        using FilterMode = HapticsConditioner::FilterMode;
+
+        struct Configuration {
+            const char* name;
+            Settings settings;
+        };
+
+        Settings make_settings(bool dc_blocker, FilterMode filter_mode, bool compressor) {
+            Settings settings;
+            settings.dc_blocker = dc_blocker;
+            settings.filter_mode = filter_mode;
+            settings.compressor = compressor;
+            return settings;
+        }
+
+        std::vector<float> make_sine(double frequency, float amplitude) {
+            std::vector<float> frames(static_cast<size_t>(BLOCK_FRAMES) * CHANNELS);
+
+            // A whole number of periods per block keeps the signal continuous when the block is repeated
+            const double periods = std::max(1.0, std::round(frequency * BLOCK_FRAMES / SAMPLE_RATE));
+
+            for (uint32_t frame = 0; frame < BLOCK_FRAMES; ++frame) {
+                const auto value = static_cast<float>(amplitude * std::sin(2.0 * std::numbers::pi * periods * frame / BLOCK_FRAMES));
+                frames[frame * CHANNELS] = value;
+                frames[frame * CHANNELS + 1] = value;
+            }
+
+            return frames;
+        }
+
+        /// Peak of the output once the conditioner has settled on the repeated `input` block.
+        float get_settled_peak(const Settings& settings, const std::vector<float>& input) {
+            HapticsConditioner conditioner;
+            conditioner.set_sample_rate(SAMPLE_RATE);
+            conditioner.set_settings(settings);
+
+            std::vector<float> block = input;
+            for (int i_block = 0; i_block < SETTLING_BLOCKS; ++i_block) {
+                block = input;
+                conditioner.process(block.data(), BLOCK_FRAMES);
+            }
+
+            float peak = 0.0f;
+            for (const float sample : block) {
+                peak = std::max(peak, std::abs(sample));
+            }
+
+            return peak;
+        }
+    } // namespace
+
+    bool run_conditioner_benchmark(const Options&) {
+        const Configuration configurations[] = {
+            {"dc blocker", make_settings(true, FilterMode::Disabled, false)},
+            {"low-pass", make_settings(false, FilterMode::LowPass, false)},
+            {"band-pass", make_settings(false, FilterMode::BandPass, false)},
+            {"compressor", make_settings(false, FilterMode::Disabled, true)},
+            {"full chain", make_settings(true, FilterMode::LowPass, true)},
+        };
+
+        const double period_ns = 1e9 * BLOCK_FRAMES / SAMPLE_RATE;
+        const std::vector<float> input = make_sine(100.0, 0.5f);
+
+        std::printf("%u Hz, %u frame blocks (%.1f ms mix period)\n\n", SAMPLE_RATE, BLOCK_FRAMES, period_ns / 1e6);
+        std::printf("%-20s %10s %12s %12s\n", "stages", "ns/frame", "cycles/frame", "% of period");
+
+        for (const Configuration& configuration : configurations) {
+            HapticsConditioner conditioner;
+            conditioner.set_sample_rate(SAMPLE_RATE);
+            conditioner.set_settings(configuration.settings);
+
+            std::vector<float> block = input;
+            const Measurement measurement = measure([&] {
+                // Processing the previous output again would keep shrinking the signal, so every call starts from the input
+                std::copy(input.begin(), input.end(), block.begin());
+                conditioner.process(block.data(), BLOCK_FRAMES);
+                do_not_optimize(block.data());
+            });
+
+            std::printf(
+                "%-20s %10.2f %12.2f %11.3f%%\n",
+                configuration.name,
+                measurement.ns / BLOCK_FRAMES,
+                measurement.cycles / BLOCK_FRAMES,
+                measurement.ns / period_ns * 100.0
+            );
+        }
+
+        // The limiter holds the ceiling on a signal far above it. A ratio of 1 leaves the limiter to do all the work.
+        Settings limiter = make_settings(false, FilterMode::Disabled, true);
+        limiter.compressor_ratio = 1.0f;
+        const float ceiling = std::pow(10.0f, limiter.limiter_ceiling_db / 20.0f);
+        const float limited_peak = get_settled_peak(limiter, make_sine(100.0, 2.0f));
+        const bool ceiling_held = limited_peak <= ceiling * 1.001f;
+
+        // The low-pass removes content well above its cutoff
+        const Settings low_pass = make_settings(false, FilterMode::LowPass, false);
+        const float attenuation_db = 20.0f * std::log10(get_settled_peak(low_pass, make_sine(4000.0, 0.5f)) / 0.5f);
+        const bool filtered = attenuation_db < -20.0f;
+
+        std::printf("\nlimiter peak %.3f against a ceiling of %.3f: %s\n", limited_peak, ceiling, ceiling_held ? "ok" : "FAILED");
+        std::printf("4 kHz through the %.0f Hz low-pass: %.1f dB: %s\n", low_pass.filter_cutoff_hz, attenuation_db, filtered ? "ok" : "FAILED");
+
+        return ceiling_held && filtered;
+    }
+} // namespace hd_haptics::bench
@@ -0,0 +1,3 @@
+// The extension gets the miniaudio implementation from HapticsDevice.cpp, which depends on Godot
+#define MINIAUDIO_IMPLEMENTATION
+#include "external/miniaudio_init.h"
@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <numbers>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "HapticsRenderer.h"
+#include "HapticsStreamWriter.h"
+
+namespace hd_haptics::bench {
+    namespace {
+        // Godot's default mix rate and block size, and a DualSense running at its native rate with 10 ms periods
+        constexpr uint32_t MIX_RATE = 44100;
+        constexpr uint32_t MIX_BLOCK_FRAMES = 512;
+        constexpr uint32_t DEVICE_RATE = 48000;
+        constexpr uint32_t DEVICE_PERIOD_FRAMES = 480;
+        constexpr double TARGET_LATENCY_MS = 40.0;
+
+        constexpr double SIGNAL_HZ = 100.0;
+        constexpr float SIGNAL_AMPLITUDE = 0.5f;
+
+        // Simulated time per scenario. The simulation runs as fast as the pipeline allows.
+        constexpr double SIMULATED_SECONDS = 60.0;
+
+        struct Scenario {
+            const char* name;
+            // Relative speed of the device clock against the mix clock
+            double drift;
+            // Blocks and callbacks arrive up to this late, the ones after them are delivered in a burst
+            double mix_jitter_ms;
+            double device_jitter_ms;
+        };
+
+        constexpr Scenario SCENARIOS[] = {
+            {"steady", 0.0, 0.0, 0.0},
+            {"device +0.1%", 0.001, 0.0, 0.0},
+            {"device -0.1%", -0.001, 0.0, 0.0},
+            {"jitter 10 ms", 0.0, 10.0, 2.0},
+            {"jitter + drift +0.1%", 0.001, 10.0, 2.0},
+            {"jitter + drift -0.1%", -0.001, 10.0, 2.0},
+        };
+
+        /// A sine on the left channel and its inverse on the right.
+        class SignalGenerator {
+        public:
+            void generate(float* p_frames, uint32_t frame_count) {
+                for (uint32_t frame = 0; frame < frame_count; ++frame) {
+                    const auto value = static_cast<float>(SIGNAL_AMPLITUDE * std::sin(m_phase));
+                    p_frames[frame * 2] = value;
+                    p_frames[frame * 2 + 1] = -value;
+
+                    m_phase = std::fmod(m_phase + 2.0 * std::numbers::pi * SIGNAL_HZ / MIX_RATE, 2.0 * std::numbers::pi);
+                }
+            }
+
+        private:
+            double m_phase = 0.0;
+        };
+
+        /// Checks the device output: the front pair stays silent, the back pair carries the sine unchanged in
+        /// level and with the inverted right channel, and there are no steps beyond what the sine itself produces.
+        class OutputChecker {
+        public:
+            void check(const float* p_output, uint32_t frame_count) {
+                // Slope of the sine per device frame, with room for the drift correction and the filter ripple
+                const auto max_step = static_cast<float>(2.0 * std::numbers::pi * SIGNAL_HZ * SIGNAL_AMPLITUDE / DEVICE_RATE * 1.1);
+
+                for (uint32_t frame = 0; frame < frame_count; ++frame) {
+                    const float* p_frame = p_output + static_cast<size_t>(frame) * HapticsRenderer::OUTPUT_CHANNELS;
+
+                    if (p_frame[0] != 0.0f || p_frame[1] != 0.0f) {
+                        ++m_front_errors;
+                    }
+
+                    m_channel_mismatch = std::max(m_channel_mismatch, std::abs(p_frame[2] + p_frame[3]));
+                    m_peak = std::max(m_peak, std::abs(p_frame[2]));
+
+                    if (std::abs(p_frame[2] - m_previous) > max_step) {
+                        ++m_glitches;
+                    }
+
+                    m_previous = p_frame[2];
+                }
+            }
+
+            /// Glitches are only expected when the pipeline reported running dry or dropping frames.
+            [[nodiscard]] bool passed(const HapticsStats::Snapshot& snapshot) const {
+                const bool explained_glitches = m_glitches == 0 || snapshot.underruns > 0 || snapshot.dropped_frames > 0;
+                return m_front_errors == 0 && m_channel_mismatch < 1e-6f && std::abs(m_peak - SIGNAL_AMPLITUDE) < SIGNAL_AMPLITUDE * 0.01f &&
+                       explained_glitches;
+            }
+
+            [[nodiscard]] uint64_t get_glitches() const {
+                return m_glitches;
+            }
+
+        private:
+            uint64_t m_front_errors = 0;
+            uint64_t m_glitches = 0;
+            float m_channel_mismatch = 0.0f;
+            float m_peak = 0.0f;
+            float m_previous = 0.0f;
+        };
+
+        /// One stream fed by a writer and read by the renderer of a single controller, like one effect instance
+        /// routed to one DualSense.
+        struct Pipeline {
+            std::shared_ptr<HapticsStream> stream;
+            HapticsStreamWriter writer;
+            HapticsRenderer renderer;
+
+            Pipeline() {
+                HapticsStream::Config config;
+                config.sample_rate = MIX_RATE;
+                config.target_frames = static_cast<uint32_t>(TARGET_LATENCY_MS * MIX_RATE / 1000.0);
+
+                stream = std::make_shared<HapticsStream>(config);
+                stream->set_live(true);
+                writer.initialize(stream);
+
+                renderer.initialize(0, DEVICE_RATE);
+                renderer.set_device_buffer_frames(DEVICE_PERIOD_FRAMES * 2);
+                renderer.set_streams({stream});
+            }
+        };
+
+        struct Timing {
+            double write_ns = 0.0;
+            double render_ns = 0.0;
+            uint64_t rendered_frames = 0;
+        };
+
+        void print_header() {
+            std::printf(
+                "%-22s %9s %9s %10s %8s %8s %8s %9s %8s %8s %10s %8s %s\n",
+                "scenario",
+                "render",
+                "write",
+                "realtime",
+                "p50",
+                "p99",
+                "max",
+                "underrun",
+                "overrun",
+                "dropped",
+                "latency",
+                "glitches",
+                "output"
+            );
+            std::printf("%-22s %9s %9s %10s %8s %8s %8s\n", "", "ns/frame", "ns/frame", "factor", "us", "us", "us");
+        }
+
+        bool print_result(const char* name, const Pipeline& pipeline, const Timing& timing, double seconds, const OutputChecker& checker) {
+            const HapticsStats::Snapshot snapshot = pipeline.stream->get_stats().get_snapshot();
+            const bool passed = checker.passed(snapshot);
+
+            std::printf(
+                "%-22s %9.1f %9.1f %10.0f %8.1f %8.1f %8.1f %9llu %8llu %8llu %8.1fms %8llu %s\n",
+                name,
+                timing.render_ns / static_cast<double>(timing.rendered_frames),
+                timing.write_ns / (seconds * MIX_RATE),
+                seconds * 1e9 / (timing.render_ns + timing.write_ns),
+                static_cast<double>(snapshot.callback_p50_ns) / 1000.0,
+                static_cast<double>(snapshot.callback_p99_ns) / 1000.0,
+                static_cast<double>(snapshot.callback_max_ns) / 1000.0,
+                static_cast<unsigned long long>(snapshot.underruns),
+                static_cast<unsigned long long>(snapshot.overruns),
+                static_cast<unsigned long long>(snapshot.dropped_frames),
+                snapshot.latency_frames * 1000.0 / MIX_RATE,
+                static_cast<unsigned long long>(checker.get_glitches()),
+                passed ? "ok" : "FAILED"
+            );
+
+            return passed;
+        }
+
+        /// Steps through the mix blocks and device callbacks in the order a real clock would deliver them,
+        /// without waiting in between.
+        bool run_simulated(const Scenario& scenario) {
+            Pipeline pipeline;
+            SignalGenerator generator;
+            OutputChecker checker;
+            Timing timing;
+
+            std::mt19937 random(1);
+            std::uniform_real_distribution<double> jitter(0.0, 1.0);
+
+            std::vector<float> block(static_cast<size_t>(MIX_BLOCK_FRAMES) * HapticsRenderer::INPUT_CHANNELS);
+            std::vector<float> output(static_cast<size_t>(DEVICE_PERIOD_FRAMES) * HapticsRenderer::OUTPUT_CHANNELS);
+
+            const double block_seconds = static_cast<double>(MIX_BLOCK_FRAMES) / MIX_RATE;
+            const double period_seconds = DEVICE_PERIOD_FRAMES / (DEVICE_RATE * (1.0 + scenario.drift));
+
+            uint64_t block_index = 0;
+            uint64_t callback_index = 0;
+            double next_block_time = 0.0;
+            double next_callback_time = 0.0;
+
+            while (next_callback_time < SIMULATED_SECONDS) {
+                if (next_block_time <= next_callback_time) {
+                    generator.generate(block.data(), MIX_BLOCK_FRAMES);
+
+                    const auto start = std::chrono::steady_clock::now();
+                    pipeline.writer.write(block.data(), MIX_BLOCK_FRAMES);
+                    timing.write_ns += get_elapsed_ns(start);
+
+                    ++block_index;
+                    const double due_time = static_cast<double>(block_index) * block_seconds + jitter(random) * scenario.mix_jitter_ms / 1000.0;
+                    next_block_time = std::max(next_block_time, due_time);
+                } else {
+                    const auto start = std::chrono::steady_clock::now();
+                    pipeline.renderer.render(output.data(), DEVICE_PERIOD_FRAMES);
+                    timing.render_ns += get_elapsed_ns(start);
+                    timing.rendered_frames += DEVICE_PERIOD_FRAMES;
+
+                    checker.check(output.data(), DEVICE_PERIOD_FRAMES);
+
+                    ++callback_index;
+                    const double due_time = static_cast<double>(callback_index) * period_seconds + jitter(random) * scenario.device_jitter_ms / 1000.0;
+                    next_callback_time = std::max(next_callback_time, due_time);
+                }
+            }
+
+            return print_result(scenario.name, pipeline, timing, SIMULATED_SECONDS, checker);
+        }
+
+        /// Runs the mix and the device on their own threads, paced by the wall clock like the real thing. The
+        /// device clock runs 0.1% fast and the mix blocks arrive with up to 5 ms of jitter.
+        bool run_realtime(double seconds) {
+            constexpr double DRIFT = 0.001;
+            constexpr double MIX_JITTER_MS = 5.0;
+
+            Pipeline pipeline;
+            OutputChecker checker;
+            Timing timing;
+            std::atomic<bool> running = true;
+
+            const auto start_time = std::chrono::steady_clock::now();
+            const auto time_point_at = [start_time](double elapsed_seconds) {
+                return start_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(elapsed_seconds));
+            };
+
+            const double block_seconds = static_cast<double>(MIX_BLOCK_FRAMES) / MIX_RATE;
+            const double period_seconds = DEVICE_PERIOD_FRAMES / (DEVICE_RATE * (1.0 + DRIFT));
+
+            std::thread mix_thread([&] {
+                SignalGenerator generator;
+                std::vector<float> block(static_cast<size_t>(MIX_BLOCK_FRAMES) * HapticsRenderer::INPUT_CHANNELS);
+                std::mt19937 random(2);
+                std::uniform_real_distribution<double> jitter(0.0, MIX_JITTER_MS / 1000.0);
+
+                for (uint64_t block_index = 0; running.load(); ++block_index) {
+                    std::this_thread::sleep_until(time_point_at(static_cast<double>(block_index) * block_seconds + jitter(random)));
+
+                    generator.generate(block.data(), MIX_BLOCK_FRAMES);
+
+                    const auto start = std::chrono::steady_clock::now();
+                    pipeline.writer.write(block.data(), MIX_BLOCK_FRAMES);
+                    timing.write_ns += get_elapsed_ns(start);
+                }
+            });
+
+            std::vector<float> output(static_cast<size_t>(DEVICE_PERIOD_FRAMES) * HapticsRenderer::OUTPUT_CHANNELS);
+
+            for (uint64_t callback_index = 0; std::chrono::steady_clock::now() < time_point_at(seconds); ++callback_index) {
+                std::this_thread::sleep_until(time_point_at(static_cast<double>(callback_index) * period_seconds));
+
+                const auto start = std::chrono::steady_clock::now();
+                pipeline.renderer.render(output.data(), DEVICE_PERIOD_FRAMES);
+                timing.render_ns += get_elapsed_ns(start);
+                timing.rendered_frames += DEVICE_PERIOD_FRAMES;
+
+                checker.check(output.data(), DEVICE_PERIOD_FRAMES);
+            }
+
+            running.store(false);
+            mix_thread.join();
+
+            return print_result("real-time +0.1%", pipeline, timing, seconds, checker);
+        }
+    } // namespace
+
+    bool run_pipeline_benchmark(const Options& options) {
+        std::printf(
+            "%u Hz mix in %u frame blocks -> %u Hz device with %u frame periods, %.0f ms target latency, %.0f s simulated per scenario\n\n",
+            MIX_RATE,
+            MIX_BLOCK_FRAMES,
+            DEVICE_RATE,
+            DEVICE_PERIOD_FRAMES,
+            TARGET_LATENCY_MS,
+            SIMULATED_SECONDS
+        );
+        print_header();
+
+        bool passed = true;
+
+        for (const Scenario& scenario : SCENARIOS) {
+            passed = run_simulated(scenario) && passed;
+        }
+
+        if (options.realtime_seconds > 0.0) {
+            passed = run_realtime(options.realtime_seconds) && passed;
+        }
+
+        return passed;
+    }
+} // namespace hd_haptics::bench
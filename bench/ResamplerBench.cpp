@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <numbers>
+#include <vector>
+
+#include "Bench.h"
+#include "DriftCompensator.h"
+#include "PolyphaseResampler.h"
+#include "external/miniaudio_init.h"
+
+namespace hd_haptics::bench {
+    namespace {
+        // Godot's default mix rate to the native rate of the DualSense, in 10 ms device periods
+        constexpr uint32_t INPUT_RATE = 44100;
+        constexpr uint32_t OUTPUT_RATE = 48000;
+        constexpr uint32_t INPUT_BLOCK_FRAMES = 441;
+        constexpr uint32_t OUTPUT_BLOCK_FRAMES = 480;
+        constexpr int CHANNELS = PolyphaseResampler::CHANNELS;
+
+        using Quality = PolyphaseResampler::Quality;
+
+        struct Tier {
+            const char* name;
+            Quality quality;
+            // Required error at 100 Hz, the band haptics live in. Linear interpolation has no requirement.
+            double max_error_db;
+        };
+
+        constexpr Tier TIERS[] = {
+            {"Linear", Quality::Linear, 0.0},
+            {"Standard", Quality::Standard, -70.0},
+            {"High", Quality::High, -90.0},
+        };
+
+        constexpr double TEST_FREQUENCIES[] = {100.0, 1000.0, 8000.0};
+
+        /// Largest difference between the resampled sine and the ideal one, in dB relative to full scale.
+        double get_error_db(Quality quality, double frequency) {
+            PolyphaseResampler resampler;
+            resampler.initialize(quality, INPUT_RATE, OUTPUT_RATE);
+
+            const double step = static_cast<double>(INPUT_RATE) / OUTPUT_RATE;
+            double phase = 1.0;
+            uint64_t pushed_frames = 0;
+            double max_error = 0.0;
+
+            for (uint32_t output_frame = 0; output_frame < OUTPUT_RATE; ++output_frame) {
+                while (phase >= 1.0) {
+                    const auto value = static_cast<float>(std::sin(2.0 * std::numbers::pi * frequency * static_cast<double>(pushed_frames) / INPUT_RATE));
+                    const float frame[CHANNELS] = {value, value};
+                    resampler.push(frame);
+                    ++pushed_frames;
+                    phase -= 1.0;
+                }
+
+                float output[CHANNELS];
+                resampler.interpolate(static_cast<float>(phase), output);
+
+                // The interpolated position lags behind the newest frame by the filter latency
+                const double position = static_cast<double>(pushed_frames) - 2.0 - resampler.get_latency_frames() + phase;
+                const double ideal = std::sin(2.0 * std::numbers::pi * frequency * position / INPUT_RATE);
+
+                // Skip the frames the filter needs to fill its history
+                if (output_frame > PolyphaseResampler::MAX_TAPS * 2) {
+                    max_error = std::max(max_error, std::abs(output[0] - ideal));
+                }
+
+                phase += step;
+            }
+
+            return 20.0 * std::log10(std::max(max_error, 1e-12));
+        }
+
+        /// Cost of reading the ring buffer through the DriftCompensator, the way the renderer converts every stream.
+        Measurement measure_drift_compensator(Quality quality) {
+            BroadcastRingBuffer ring_buffer;
+            ring_buffer.initialize(8192, 1024);
+            BroadcastRingBuffer::Reader reader;
+            reader.attach(ring_buffer);
+
+            DriftCompensator drift_compensator;
+            drift_compensator.reset(2048, INPUT_RATE, OUTPUT_RATE, false, quality);
+
+            std::vector<float> input(static_cast<size_t>(INPUT_BLOCK_FRAMES) * CHANNELS, 0.25f);
+            std::vector<float> output(static_cast<size_t>(OUTPUT_BLOCK_FRAMES) * CHANNELS);
+
+            return measure([&] {
+                ring_buffer.write(input.data(), INPUT_BLOCK_FRAMES);
+                drift_compensator.process(reader, output.data(), OUTPUT_BLOCK_FRAMES);
+                do_not_optimize(output.data());
+            });
+        }
+
+        void print_row(const char* name, const Measurement& measurement, double latency_frames, const char* error) {
+            std::printf(
+                "%-28s %10.2f %12.2f %10.1f %9.3fms  %s\n",
+                name,
+                measurement.ns / OUTPUT_BLOCK_FRAMES,
+                measurement.cycles / OUTPUT_BLOCK_FRAMES,
+                latency_frames,
+                latency_frames * 1000.0 / INPUT_RATE,
+                error
+            );
+        }
+    } // namespace
+
+    bool run_resampler_benchmark(const Options&) {
+        std::printf("%u Hz -> %u Hz stereo, %u frame output blocks\n\n", INPUT_RATE, OUTPUT_RATE, OUTPUT_BLOCK_FRAMES);
+        std::printf("%-28s %10s %12s %10s %11s  %s\n", "resampler", "ns/frame", "cycles/frame", "latency", "", "max error at 100 Hz / 1 kHz / 8 kHz");
+        std::printf("%-28s %10s %12s %10s\n", "", "", "", "frames");
+
+        bool passed = true;
+
+        for (const Tier& tier : TIERS) {
+            PolyphaseResampler resampler;
+            resampler.initialize(tier.quality, INPUT_RATE, OUTPUT_RATE);
+
+            char error[64];
+            double errors_db[std::size(TEST_FREQUENCIES)];
+            for (size_t i_frequency = 0; i_frequency < std::size(TEST_FREQUENCIES); ++i_frequency) {
+                errors_db[i_frequency] = get_error_db(tier.quality, TEST_FREQUENCIES[i_frequency]);
+            }
+            std::snprintf(error, sizeof(error), "%.0f / %.0f / %.0f dB", errors_db[0], errors_db[1], errors_db[2]);
+
+            const bool tier_passed = tier.max_error_db == 0.0 || errors_db[0] <= tier.max_error_db;
+            passed = passed && tier_passed;
+
+            char name[64];
+            std::snprintf(name, sizeof(name), "DriftCompensator %s%s", tier.name, tier_passed ? "" : " FAILED");
+
+            // Half a frame on average for the fractional position on top of the filter delay
+            print_row(name, measure_drift_compensator(tier.quality), resampler.get_latency_frames() + 0.5, error);
+        }
+
+        // The resampler ma_data_converter used when the devices were opened at the mix rate
+        const ma_resampler_config config = ma_resampler_config_init(ma_format_f32, CHANNELS, INPUT_RATE, OUTPUT_RATE, ma_resample_algorithm_linear);
+        ma_resampler resampler;
+        if (ma_resampler_init(&config, nullptr, &resampler) != MA_SUCCESS) {
+            std::printf("ma_resampler_init failed\n");
+            return false;
+        }
+
+        std::vector<float> input(static_cast<size_t>(INPUT_BLOCK_FRAMES) * CHANNELS, 0.25f);
+        // Room for the frame the resampler may produce on top when its position rounds up
+        std::vector<float> output(static_cast<size_t>(OUTPUT_BLOCK_FRAMES + 1) * CHANNELS);
+
+        const Measurement miniaudio = measure([&] {
+            ma_uint64 input_frames = INPUT_BLOCK_FRAMES;
+            ma_uint64 output_frames = OUTPUT_BLOCK_FRAMES + 1;
+            ma_resampler_process_pcm_frames(&resampler, input.data(), &input_frames, output.data(), &output_frames);
+            do_not_optimize(output.data());
+        });
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "ma_resampler linear, LPF %u", config.linear.lpfOrder);
+        print_row(name, miniaudio, static_cast<double>(ma_resampler_get_input_latency(&resampler)), "-");
+
+        ma_resampler_uninit(&resampler, nullptr);
+
+        return passed;
+    }
+} // namespace hd_haptics::bench
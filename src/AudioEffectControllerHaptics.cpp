@@ -1,15 +1,631 @@
 #include "AudioEffectControllerHaptics.h"
 #include <godot_cpp/classes/engine.hpp>
+#include <godot_cpp/core/object.hpp>
 
 #include "AudioEffectControllerHapticsInstance.h"
+#include "HapticsDeviceManager.h"
+#include "HapticsHub.h"
+#include "godot_cpp/classes/audio_server.hpp"
+#include "godot_cpp/classes/project_settings.hpp"
 
 namespace hd_haptics {
+    // Retired clips are kept this much longer than they play, for commands still queued for a device to start them
+    constexpr auto RETIRED_CLIP_GRACE = std::chrono::seconds(1);
+
     godot::Ref<godot::AudioEffectInstance> AudioEffectControllerHaptics::_instantiate() {
         godot::Ref<AudioEffectControllerHapticsInstance> instance;
         instance.instantiate();
         instance->base = godot::Ref(this);
+        instance->initialize();
+
+        // Clips are played on the devices of the most recent instance, like other effects that talk to their instance
+        std::lock_guard lock(m_clip_mutex);
+        m_current_stream = instance->m_stream;
+
         return instance;
     }
 
-    void AudioEffectControllerHaptics::_bind_methods() {}
+    void AudioEffectControllerHaptics::set_target_latency_ms(double p_target_latency_ms) {
+        m_target_latency_ms = p_target_latency_ms;
+    }
+
+    double AudioEffectControllerHaptics::get_target_latency_ms() const {
+        return m_target_latency_ms;
+    }
+
+    void AudioEffectControllerHaptics::set_overflow_policy(OverflowPolicy p_overflow_policy) {
+        m_overflow_policy = p_overflow_policy;
+    }
+
+    AudioEffectControllerHaptics::OverflowPolicy AudioEffectControllerHaptics::get_overflow_policy() const {
+        return m_overflow_policy;
+    }
+
+    void AudioEffectControllerHaptics::set_resampler_quality(ResamplerQuality p_resampler_quality) {
+        m_resampler_quality = p_resampler_quality;
+    }
+
+    AudioEffectControllerHaptics::ResamplerQuality AudioEffectControllerHaptics::get_resampler_quality() const {
+        return m_resampler_quality;
+    }
+
+    void AudioEffectControllerHaptics::set_device_share_mode(ShareMode p_device_share_mode) {
+        m_device_share_mode = p_device_share_mode;
+    }
+
+    AudioEffectControllerHaptics::ShareMode AudioEffectControllerHaptics::get_device_share_mode() const {
+        return m_device_share_mode;
+    }
+
+    void AudioEffectControllerHaptics::set_device_performance_profile(PerformanceProfile p_device_performance_profile) {
+        m_device_performance_profile = p_device_performance_profile;
+    }
+
+    AudioEffectControllerHaptics::PerformanceProfile AudioEffectControllerHaptics::get_device_performance_profile() const {
+        return m_device_performance_profile;
+    }
+
+    void AudioEffectControllerHaptics::set_device_period_mode(PeriodMode p_device_period_mode) {
+        m_device_period_mode = p_device_period_mode;
+    }
+
+    AudioEffectControllerHaptics::PeriodMode AudioEffectControllerHaptics::get_device_period_mode() const {
+        return m_device_period_mode;
+    }
+
+    void AudioEffectControllerHaptics::set_device_period_ms(int64_t p_device_period_ms) {
+        m_device_period_ms = p_device_period_ms;
+    }
+
+    int64_t AudioEffectControllerHaptics::get_device_period_ms() const {
+        return m_device_period_ms;
+    }
+
+    HapticsHub::DeviceSettings AudioEffectControllerHaptics::get_device_settings() const {
+        HapticsHub::DeviceSettings settings;
+        settings.device.share_mode = m_device_share_mode == SHARE_MODE_EXCLUSIVE ? ma_share_mode_exclusive : ma_share_mode_shared;
+        settings.device.performance_profile =
+            m_device_performance_profile == PERFORMANCE_PROFILE_CONSERVATIVE ? ma_performance_profile_conservative : ma_performance_profile_low_latency;
+        settings.device.period_ms = m_device_period_mode == PERIOD_MODE_FIXED ? static_cast<uint32_t>(m_device_period_ms) : 0;
+        settings.calibrate_period = m_device_period_mode == PERIOD_MODE_CALIBRATED;
+
+        return settings;
+    }
+
+    void AudioEffectControllerHaptics::set_idle_timeout_ms(double p_idle_timeout_ms) {
+        m_idle_timeout_ms = p_idle_timeout_ms;
+    }
+
+    double AudioEffectControllerHaptics::get_idle_timeout_ms() const {
+        return m_idle_timeout_ms;
+    }
+
+    void AudioEffectControllerHaptics::set_pass_through(bool p_pass_through) {
+        m_pass_through = p_pass_through;
+    }
+
+    bool AudioEffectControllerHaptics::is_pass_through() const {
+        return m_pass_through;
+    }
+
+    void AudioEffectControllerHaptics::set_routing(Routing p_routing) {
+        m_routing = p_routing;
+    }
+
+    AudioEffectControllerHaptics::Routing AudioEffectControllerHaptics::get_routing() const {
+        return m_routing;
+    }
+
+    void AudioEffectControllerHaptics::set_controllers(int64_t p_controllers) {
+        m_controllers = p_controllers;
+    }
+
+    int64_t AudioEffectControllerHaptics::get_controllers() const {
+        return m_controllers;
+    }
+
+    void AudioEffectControllerHaptics::set_left_gain(float p_left_gain) {
+        m_left_gain = p_left_gain;
+    }
+
+    float AudioEffectControllerHaptics::get_left_gain() const {
+        return m_left_gain;
+    }
+
+    void AudioEffectControllerHaptics::set_right_gain(float p_right_gain) {
+        m_right_gain = p_right_gain;
+    }
+
+    float AudioEffectControllerHaptics::get_right_gain() const {
+        return m_right_gain;
+    }
+
+    void AudioEffectControllerHaptics::set_priority(int64_t p_priority) {
+        m_priority = p_priority;
+    }
+
+    int64_t AudioEffectControllerHaptics::get_priority() const {
+        return m_priority;
+    }
+
+    void AudioEffectControllerHaptics::set_ducking_db(float p_ducking_db) {
+        m_ducking_db = p_ducking_db;
+    }
+
+    float AudioEffectControllerHaptics::get_ducking_db() const {
+        return m_ducking_db;
+    }
+
+    void AudioEffectControllerHaptics::set_dc_blocker(bool p_dc_blocker) {
+        m_conditioner_settings.dc_blocker = p_dc_blocker;
+    }
+
+    bool AudioEffectControllerHaptics::get_dc_blocker() const {
+        return m_conditioner_settings.dc_blocker;
+    }
+
+    void AudioEffectControllerHaptics::set_filter_mode(FilterMode p_filter_mode) {
+        m_conditioner_settings.filter_mode = static_cast<HapticsConditioner::FilterMode>(p_filter_mode);
+    }
+
+    AudioEffectControllerHaptics::FilterMode AudioEffectControllerHaptics::get_filter_mode() const {
+        return static_cast<FilterMode>(m_conditioner_settings.filter_mode);
+    }
+
+    void AudioEffectControllerHaptics::set_filter_cutoff_hz(float p_filter_cutoff_hz) {
+        m_conditioner_settings.filter_cutoff_hz = p_filter_cutoff_hz;
+    }
+
+    float AudioEffectControllerHaptics::get_filter_cutoff_hz() const {
+        return m_conditioner_settings.filter_cutoff_hz;
+    }
+
+    void AudioEffectControllerHaptics::set_filter_resonance(float p_filter_resonance) {
+        m_conditioner_settings.filter_resonance = p_filter_resonance;
+    }
+
+    float AudioEffectControllerHaptics::get_filter_resonance() const {
+        return m_conditioner_settings.filter_resonance;
+    }
+
+    void AudioEffectControllerHaptics::set_compressor_enabled(bool p_compressor_enabled) {
+        m_conditioner_settings.compressor = p_compressor_enabled;
+    }
+
+    bool AudioEffectControllerHaptics::get_compressor_enabled() const {
+        return m_conditioner_settings.compressor;
+    }
+
+    void AudioEffectControllerHaptics::set_compressor_threshold_db(float p_compressor_threshold_db) {
+        m_conditioner_settings.compressor_threshold_db = p_compressor_threshold_db;
+    }
+
+    float AudioEffectControllerHaptics::get_compressor_threshold_db() const {
+        return m_conditioner_settings.compressor_threshold_db;
+    }
+
+    void AudioEffectControllerHaptics::set_compressor_ratio(float p_compressor_ratio) {
+        m_conditioner_settings.compressor_ratio = p_compressor_ratio;
+    }
+
+    float AudioEffectControllerHaptics::get_compressor_ratio() const {
+        return m_conditioner_settings.compressor_ratio;
+    }
+
+    void AudioEffectControllerHaptics::set_compressor_attack_ms(float p_compressor_attack_ms) {
+        m_conditioner_settings.compressor_attack_ms = p_compressor_attack_ms;
+    }
+
+    float AudioEffectControllerHaptics::get_compressor_attack_ms() const {
+        return m_conditioner_settings.compressor_attack_ms;
+    }
+
+    void AudioEffectControllerHaptics::set_compressor_release_ms(float p_compressor_release_ms) {
+        m_conditioner_settings.compressor_release_ms = p_compressor_release_ms;
+    }
+
+    float AudioEffectControllerHaptics::get_compressor_release_ms() const {
+        return m_conditioner_settings.compressor_release_ms;
+    }
+
+    void AudioEffectControllerHaptics::set_compressor_ceiling_db(float p_compressor_ceiling_db) {
+        m_conditioner_settings.limiter_ceiling_db = p_compressor_ceiling_db;
+    }
+
+    float AudioEffectControllerHaptics::get_compressor_ceiling_db() const {
+        return m_conditioner_settings.limiter_ceiling_db;
+    }
+
+    uint32_t AudioEffectControllerHaptics::get_controller_mask() const {
+        return m_routing == ROUTING_BROADCAST ? ~0u : static_cast<uint32_t>(m_controllers);
+    }
+
+    godot::Array AudioEffectControllerHaptics::get_connected_controllers() {
+        godot::Array controllers;
+
+        if (auto* manager = HapticsDeviceManager::get_singleton()) {
+            for (const auto& device : manager->get_devices()) {
+                controllers.push_back(device.controller_index);
+            }
+        }
+
+        return controllers;
+    }
+
+    // Accepts res:// and user:// paths like the rest of Godot
+    static std::filesystem::path to_filesystem_path(const godot::String& p_path) {
+        const godot::CharString utf8_path = godot::ProjectSettings::get_singleton()->globalize_path(p_path).utf8();
+        return {reinterpret_cast<const char8_t*>(utf8_path.get_data())};
+    }
+
+    bool AudioEffectControllerHaptics::start_capture(const godot::String& p_path) {
+        auto* hub = HapticsHub::get_singleton();
+        ERR_FAIL_NULL_V(hub, false);
+        ERR_FAIL_COND_V_MSG(!hub->start_capture(to_filesystem_path(p_path)), false, "Failed to create the haptics capture file.");
+
+        return true;
+    }
+
+    void AudioEffectControllerHaptics::stop_capture() {
+        if (auto* hub = HapticsHub::get_singleton()) {
+            hub->stop_capture();
+        }
+    }
+
+    bool AudioEffectControllerHaptics::is_capturing() {
+        auto* hub = HapticsHub::get_singleton();
+        return hub != nullptr && hub->is_capturing();
+    }
+
+    bool AudioEffectControllerHaptics::start_replay(const godot::String& p_path, int64_t p_source_controller) {
+        auto* hub = HapticsHub::get_singleton();
+        ERR_FAIL_NULL_V(hub, false);
+        ERR_FAIL_COND_V_MSG(
+            !hub->start_replay(to_filesystem_path(p_path), static_cast<int>(p_source_controller)),
+            false,
+            "Failed to replay the haptics capture, it is missing, invalid or holds nothing for the source controller."
+        );
+
+        return true;
+    }
+
+    void AudioEffectControllerHaptics::stop_replay() {
+        if (auto* hub = HapticsHub::get_singleton()) {
+            hub->stop_replay();
+        }
+    }
+
+    bool AudioEffectControllerHaptics::is_replaying() {
+        auto* hub = HapticsHub::get_singleton();
+        return hub != nullptr && hub->is_replaying();
+    }
+
+    const HapticsClip* AudioEffectControllerHaptics::get_or_decode_clip(const godot::Ref<godot::AudioStreamWAV>& p_clip, std::unique_lock<std::mutex>& lock) {
+        ERR_FAIL_COND_V_MSG(p_clip.is_null(), nullptr, "Clip is null.");
+
+        const uint64_t clip_id = p_clip->get_instance_id();
+
+        if (auto it = m_clip_cache.find(clip_id); it != m_clip_cache.end()) {
+            return it->second.get();
+        }
+
+        // Decoding takes a while for long clips, don't keep other scripts from playing cached ones meanwhile
+        lock.unlock();
+        std::unique_ptr<HapticsClip> clip = decode_clip(p_clip);
+        lock.lock();
+
+        if (clip == nullptr) {
+            return nullptr;
+        }
+
+        prune_clip_cache();
+
+        // Another thread may have decoded the same clip meanwhile, keep the one already handed out
+        return m_clip_cache.try_emplace(clip_id, std::move(clip)).first->second.get();
+    }
+
+    std::unique_ptr<HapticsClip> AudioEffectControllerHaptics::decode_clip(const godot::Ref<godot::AudioStreamWAV>& p_clip) {
+        int bits_per_sample;
+        switch (p_clip->get_format()) {
+            case godot::AudioStreamWAV::FORMAT_8_BITS:
+                bits_per_sample = 8;
+                break;
+            case godot::AudioStreamWAV::FORMAT_16_BITS:
+                bits_per_sample = 16;
+                break;
+            default:
+                ERR_FAIL_V_MSG(nullptr, "Only 8 and 16 bit PCM clips are supported.");
+        }
+
+        const godot::PackedByteArray data = p_clip->get_data();
+        auto clip = HapticsClip::decode_pcm(
+            data.ptr(),
+            static_cast<size_t>(data.size()),
+            bits_per_sample,
+            p_clip->is_stereo() ? 2 : 1,
+            static_cast<uint32_t>(p_clip->get_mix_rate()),
+            static_cast<uint32_t>(godot::AudioServer::get_singleton()->get_mix_rate())
+        );
+        ERR_FAIL_NULL_V_MSG(clip, nullptr, "Failed to decode clip.");
+
+        return clip;
+    }
+
+    void AudioEffectControllerHaptics::prune_clip_cache() {
+        const auto now = std::chrono::steady_clock::now();
+
+        std::erase_if(m_retired_clips, [&](const RetiredClip& retired_clip) { return retired_clip.release_time <= now; });
+
+        // Voices hold on to the decoded frames, so a clip can only go once the longest it may still play has passed
+        const double sample_rate = godot::AudioServer::get_singleton()->get_mix_rate();
+
+        for (auto it = m_clip_cache.begin(); it != m_clip_cache.end();) {
+            if (godot::ObjectDB::get_instance(it->first) != nullptr) {
+                ++it;
+                continue;
+            }
+
+            const auto duration = std::chrono::duration<double>(it->second->get_frame_count() / sample_rate);
+            m_retired_clips.push_back({std::move(it->second), now + std::chrono::ceil<std::chrono::milliseconds>(duration) + RETIRED_CLIP_GRACE});
+            it = m_clip_cache.erase(it);
+        }
+    }
+
+    bool AudioEffectControllerHaptics::preload_clip(const godot::Ref<godot::AudioStreamWAV>& p_clip) {
+        std::unique_lock lock(m_clip_mutex);
+        return get_or_decode_clip(p_clip, lock) != nullptr;
+    }
+
+    bool AudioEffectControllerHaptics::play_clip(const godot::Ref<godot::AudioStreamWAV>& p_clip, float p_gain, ClipChannel p_channel, int64_t p_controllers) {
+        std::unique_lock lock(m_clip_mutex);
+
+        const HapticsClip* clip = get_or_decode_clip(p_clip, lock);
+        if (clip == nullptr) {
+            return false;
+        }
+
+        auto stream = m_current_stream.lock();
+        if (stream == nullptr) {
+            return false;
+        }
+
+        HapticsClipQueue::Command command;
+        command.clip = clip;
+        command.gains = {p_channel == CLIP_CHANNEL_RIGHT ? 0.0f : p_gain, p_channel == CLIP_CHANNEL_LEFT ? 0.0f : p_gain};
+        command.controller_mask = p_controllers < 0 ? get_controller_mask() : static_cast<uint32_t>(p_controllers);
+        stream->push_clip_command(command);
+
+        // Suspended devices don't run their callbacks, so they would only see the command once bus audio wakes them
+        stream->mark_active();
+
+        return true;
+    }
+
+    void AudioEffectControllerHaptics::stop_clips() {
+        std::lock_guard lock(m_clip_mutex);
+
+        if (auto stream = m_current_stream.lock()) {
+            stream->push_clip_command({});
+        }
+    }
+
+    void AudioEffectControllerHaptics::_bind_methods() {
+        godot::ClassDB::bind_method(godot::D_METHOD("set_target_latency_ms", "target_latency_ms"), &AudioEffectControllerHaptics::set_target_latency_ms);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_target_latency_ms"), &AudioEffectControllerHaptics::get_target_latency_ms);
+        godot::ClassDB::bind_method(godot::D_METHOD("set_overflow_policy", "overflow_policy"), &AudioEffectControllerHaptics::set_overflow_policy);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_overflow_policy"), &AudioEffectControllerHaptics::get_overflow_policy);
+        godot::ClassDB::bind_method(godot::D_METHOD("set_resampler_quality", "resampler_quality"), &AudioEffectControllerHaptics::set_resampler_quality);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_resampler_quality"), &AudioEffectControllerHaptics::get_resampler_quality);
+        godot::ClassDB::bind_method(godot::D_METHOD("set_device_share_mode", "device_share_mode"), &AudioEffectControllerHaptics::set_device_share_mode);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_device_share_mode"), &AudioEffectControllerHaptics::get_device_share_mode);
+        godot::ClassDB::bind_method(
+            godot::D_METHOD("set_device_performance_profile", "device_performance_profile"), &AudioEffectControllerHaptics::set_device_performance_profile
+        );
+        godot::ClassDB::bind_method(godot::D_METHOD("get_device_performance_profile"), &AudioEffectControllerHaptics::get_device_performance_profile);
+        godot::ClassDB::bind_method(godot::D_METHOD("set_device_period_mode", "device_period_mode"), &AudioEffectControllerHaptics::set_device_period_mode);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_device_period_mode"), &AudioEffectControllerHaptics::get_device_period_mode);
+        godot::ClassDB::bind_method(godot::D_METHOD("set_device_period_ms", "device_period_ms"), &AudioEffectControllerHaptics::set_device_period_ms);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_device_period_ms"), &AudioEffectControllerHaptics::get_device_period_ms);
+        godot::ClassDB::bind_method(godot::D_METHOD("set_idle_timeout_ms", "idle_timeout_ms"), &AudioEffectControllerHaptics::set_idle_timeout_ms);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_idle_timeout_ms"), &AudioEffectControllerHaptics::get_idle_timeout_ms);
+        godot::ClassDB::bind_method(godot::D_METHOD("set_pass_through", "pass_through"), &AudioEffectControllerHaptics::set_pass_through);
+        godot::ClassDB::bind_method(godot::D_METHOD("is_pass_through"), &AudioEffectControllerHaptics::is_pass_through);
+        godot::ClassDB::bind_method(godot::D_METHOD("set_routing", "routing"), &AudioEffectControllerHaptics::set_routing);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_routing"), &AudioEffectControllerHaptics::get_routing);
+        godot::ClassDB::bind_method(godot::D_METHOD("set_controllers", "controllers"), &AudioEffectControllerHaptics::set_controllers);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_controllers"), &AudioEffectControllerHaptics::get_controllers);
+        godot::ClassDB::bind_method(godot::D_METHOD("set_left_gain", "left_gain"), &AudioEffectControllerHaptics::set_left_gain);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_left_gain"), &AudioEffectControllerHaptics::get_left_gain);
+        godot::ClassDB::bind_method(godot::D_METHOD("set_right_gain", "right_gain"), &AudioEffectControllerHaptics::set_right_gain);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_right_gain"), &AudioEffectControllerHaptics::get_right_gain);
+        godot::ClassDB::bind_method(godot::D_METHOD("set_priority", "priority"), &AudioEffectControllerHaptics::set_priority);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_priority"), &AudioEffectControllerHaptics::get_priority);
+        godot::ClassDB::bind_method(godot::D_METHOD("set_ducking_db", "ducking_db"), &AudioEffectControllerHaptics::set_ducking_db);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_ducking_db"), &AudioEffectControllerHaptics::get_ducking_db);
+        godot::ClassDB::bind_method(godot::D_METHOD("set_dc_blocker", "dc_blocker"), &AudioEffectControllerHaptics::set_dc_blocker);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_dc_blocker"), &AudioEffectControllerHaptics::get_dc_blocker);
+        godot::ClassDB::bind_method(godot::D_METHOD("set_filter_mode", "filter_mode"), &AudioEffectControllerHaptics::set_filter_mode);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_filter_mode"), &AudioEffectControllerHaptics::get_filter_mode);
+        godot::ClassDB::bind_method(godot::D_METHOD("set_filter_cutoff_hz", "filter_cutoff_hz"), &AudioEffectControllerHaptics::set_filter_cutoff_hz);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_filter_cutoff_hz"), &AudioEffectControllerHaptics::get_filter_cutoff_hz);
+        godot::ClassDB::bind_method(godot::D_METHOD("set_filter_resonance", "filter_resonance"), &AudioEffectControllerHaptics::set_filter_resonance);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_filter_resonance"), &AudioEffectControllerHaptics::get_filter_resonance);
+        godot::ClassDB::bind_method(godot::D_METHOD("set_compressor_enabled", "compressor_enabled"), &AudioEffectControllerHaptics::set_compressor_enabled);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_compressor_enabled"), &AudioEffectControllerHaptics::get_compressor_enabled);
+        godot::ClassDB::bind_method(
+            godot::D_METHOD("set_compressor_threshold_db", "compressor_threshold_db"), &AudioEffectControllerHaptics::set_compressor_threshold_db
+        );
+        godot::ClassDB::bind_method(godot::D_METHOD("get_compressor_threshold_db"), &AudioEffectControllerHaptics::get_compressor_threshold_db);
+        godot::ClassDB::bind_method(godot::D_METHOD("set_compressor_ratio", "compressor_ratio"), &AudioEffectControllerHaptics::set_compressor_ratio);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_compressor_ratio"), &AudioEffectControllerHaptics::get_compressor_ratio);
+        godot::ClassDB::bind_method(
+            godot::D_METHOD("set_compressor_attack_ms", "compressor_attack_ms"), &AudioEffectControllerHaptics::set_compressor_attack_ms
+        );
+        godot::ClassDB::bind_method(godot::D_METHOD("get_compressor_attack_ms"), &AudioEffectControllerHaptics::get_compressor_attack_ms);
+        godot::ClassDB::bind_method(
+            godot::D_METHOD("set_compressor_release_ms", "compressor_release_ms"), &AudioEffectControllerHaptics::set_compressor_release_ms
+        );
+        godot::ClassDB::bind_method(godot::D_METHOD("get_compressor_release_ms"), &AudioEffectControllerHaptics::get_compressor_release_ms);
+        godot::ClassDB::bind_method(
+            godot::D_METHOD("set_compressor_ceiling_db", "compressor_ceiling_db"), &AudioEffectControllerHaptics::set_compressor_ceiling_db
+        );
+        godot::ClassDB::bind_method(godot::D_METHOD("get_compressor_ceiling_db"), &AudioEffectControllerHaptics::get_compressor_ceiling_db);
+        godot::ClassDB::bind_method(godot::D_METHOD("preload_clip", "clip"), &AudioEffectControllerHaptics::preload_clip);
+        godot::ClassDB::bind_method(
+            godot::D_METHOD("play_clip", "clip", "gain", "channel", "controllers"),
+            &AudioEffectControllerHaptics::play_clip,
+            DEFVAL(1.0),
+            DEFVAL(CLIP_CHANNEL_BOTH),
+            DEFVAL(-1)
+        );
+        godot::ClassDB::bind_method(godot::D_METHOD("stop_clips"), &AudioEffectControllerHaptics::stop_clips);
+        godot::ClassDB::bind_static_method(
+            get_class_static(), godot::D_METHOD("get_connected_controllers"), &AudioEffectControllerHaptics::get_connected_controllers
+        );
+        godot::ClassDB::bind_static_method(get_class_static(), godot::D_METHOD("start_capture", "path"), &AudioEffectControllerHaptics::start_capture);
+        godot::ClassDB::bind_static_method(get_class_static(), godot::D_METHOD("stop_capture"), &AudioEffectControllerHaptics::stop_capture);
+        godot::ClassDB::bind_static_method(get_class_static(), godot::D_METHOD("is_capturing"), &AudioEffectControllerHaptics::is_capturing);
+        godot::ClassDB::bind_static_method(
+            get_class_static(), godot::D_METHOD("start_replay", "path", "source_controller"), &AudioEffectControllerHaptics::start_replay, DEFVAL(0)
+        );
+        godot::ClassDB::bind_static_method(get_class_static(), godot::D_METHOD("stop_replay"), &AudioEffectControllerHaptics::stop_replay);
+        godot::ClassDB::bind_static_method(get_class_static(), godot::D_METHOD("is_replaying"), &AudioEffectControllerHaptics::is_replaying);
+
+        ADD_PROPERTY(
+            godot::PropertyInfo(godot::Variant::FLOAT, "target_latency_ms", godot::PROPERTY_HINT_RANGE, "5,500,1,suffix:ms"),
+            "set_target_latency_ms",
+            "get_target_latency_ms"
+        );
+        ADD_PROPERTY(
+            godot::PropertyInfo(godot::Variant::INT, "overflow_policy", godot::PROPERTY_HINT_ENUM, "Drop Oldest,Time Stretch"),
+            "set_overflow_policy",
+            "get_overflow_policy"
+        );
+        ADD_PROPERTY(
+            godot::PropertyInfo(godot::Variant::INT, "resampler_quality", godot::PROPERTY_HINT_ENUM, "Linear,Standard,High"),
+            "set_resampler_quality",
+            "get_resampler_quality"
+        );
+        ADD_PROPERTY(
+            godot::PropertyInfo(godot::Variant::FLOAT, "idle_timeout_ms", godot::PROPERTY_HINT_RANGE, "0,60000,100,suffix:ms"),
+            "set_idle_timeout_ms",
+            "get_idle_timeout_ms"
+        );
+        ADD_PROPERTY(godot::PropertyInfo(godot::Variant::BOOL, "pass_through"), "set_pass_through", "is_pass_through");
+
+        ADD_PROPERTY(
+            godot::PropertyInfo(godot::Variant::INT, "routing", godot::PROPERTY_HINT_ENUM, "Broadcast,Selected Controllers"), "set_routing", "get_routing"
+        );
+        ADD_PROPERTY(
+            godot::PropertyInfo(godot::Variant::INT, "controllers", godot::PROPERTY_HINT_FLAGS, "Controller 1,Controller 2,Controller 3,Controller 4"),
+            "set_controllers",
+            "get_controllers"
+        );
+        ADD_PROPERTY(godot::PropertyInfo(godot::Variant::FLOAT, "left_gain", godot::PROPERTY_HINT_RANGE, "0,4,0.01"), "set_left_gain", "get_left_gain");
+        ADD_PROPERTY(godot::PropertyInfo(godot::Variant::FLOAT, "right_gain", godot::PROPERTY_HINT_RANGE, "0,4,0.01"), "set_right_gain", "get_right_gain");
+        ADD_PROPERTY(godot::PropertyInfo(godot::Variant::INT, "priority", godot::PROPERTY_HINT_RANGE, "-16,16,1"), "set_priority", "get_priority");
+        ADD_PROPERTY(
+            godot::PropertyInfo(godot::Variant::FLOAT, "ducking_db", godot::PROPERTY_HINT_RANGE, "-60,0,0.1,suffix:dB"), "set_ducking_db", "get_ducking_db"
+        );
+
+        ADD_PROPERTY(godot::PropertyInfo(godot::Variant::BOOL, "dc_blocker"), "set_dc_blocker", "get_dc_blocker");
+
+        ADD_GROUP("Filter", "filter_");
+        ADD_PROPERTY(
+            godot::PropertyInfo(godot::Variant::INT, "filter_mode", godot::PROPERTY_HINT_ENUM, "Disabled,Low Pass,Band Pass"),
+            "set_filter_mode",
+            "get_filter_mode"
+        );
+        ADD_PROPERTY(
+            godot::PropertyInfo(godot::Variant::FLOAT, "filter_cutoff_hz", godot::PROPERTY_HINT_RANGE, "10,2000,1,suffix:Hz"),
+            "set_filter_cutoff_hz",
+            "get_filter_cutoff_hz"
+        );
+        ADD_PROPERTY(
+            godot::PropertyInfo(godot::Variant::FLOAT, "filter_resonance", godot::PROPERTY_HINT_RANGE, "0.1,10,0.01"),
+            "set_filter_resonance",
+            "get_filter_resonance"
+        );
+
+        ADD_GROUP("Compressor", "compressor_");
+        ADD_PROPERTY(godot::PropertyInfo(godot::Variant::BOOL, "compressor_enabled"), "set_compressor_enabled", "get_compressor_enabled");
+        ADD_PROPERTY(
+            godot::PropertyInfo(godot::Variant::FLOAT, "compressor_threshold_db", godot::PROPERTY_HINT_RANGE, "-60,0,0.1,suffix:dB"),
+            "set_compressor_threshold_db",
+            "get_compressor_threshold_db"
+        );
+        ADD_PROPERTY(
+            godot::PropertyInfo(godot::Variant::FLOAT, "compressor_ratio", godot::PROPERTY_HINT_RANGE, "1,48,0.1"),
+            "set_compressor_ratio",
+            "get_compressor_ratio"
+        );
+        ADD_PROPERTY(
+            godot::PropertyInfo(godot::Variant::FLOAT, "compressor_attack_ms", godot::PROPERTY_HINT_RANGE, "0,100,0.1,suffix:ms"),
+            "set_compressor_attack_ms",
+            "get_compressor_attack_ms"
+        );
+        ADD_PROPERTY(
+            godot::PropertyInfo(godot::Variant::FLOAT, "compressor_release_ms", godot::PROPERTY_HINT_RANGE, "1,2000,1,suffix:ms"),
+            "set_compressor_release_ms",
+            "get_compressor_release_ms"
+        );
+        ADD_PROPERTY(
+            godot::PropertyInfo(godot::Variant::FLOAT, "compressor_ceiling_db", godot::PROPERTY_HINT_RANGE, "-24,0,0.1,suffix:dB"),
+            "set_compressor_ceiling_db",
+            "get_compressor_ceiling_db"
+        );
+
+        ADD_GROUP("Device", "device_");
+        ADD_PROPERTY(
+            godot::PropertyInfo(godot::Variant::INT, "device_share_mode", godot::PROPERTY_HINT_ENUM, "Shared,Exclusive"),
+            "set_device_share_mode",
+            "get_device_share_mode"
+        );
+        ADD_PROPERTY(
+            godot::PropertyInfo(godot::Variant::INT, "device_performance_profile", godot::PROPERTY_HINT_ENUM, "Low Latency,Conservative"),
+            "set_device_performance_profile",
+            "get_device_performance_profile"
+        );
+        ADD_PROPERTY(
+            godot::PropertyInfo(godot::Variant::INT, "device_period_mode", godot::PROPERTY_HINT_ENUM, "Default,Fixed,Calibrated"),
+            "set_device_period_mode",
+            "get_device_period_mode"
+        );
+        ADD_PROPERTY(
+            godot::PropertyInfo(godot::Variant::INT, "device_period_ms", godot::PROPERTY_HINT_RANGE, "1,100,1,suffix:ms"),
+            "set_device_period_ms",
+            "get_device_period_ms"
+        );
+
+        ADD_SIGNAL(godot::MethodInfo("controller_connected", godot::PropertyInfo(godot::Variant::INT, "controller_index")));
+        ADD_SIGNAL(godot::MethodInfo("controller_disconnected", godot::PropertyInfo(godot::Variant::INT, "controller_index")));
+
+        BIND_ENUM_CONSTANT(OVERFLOW_POLICY_DROP_OLDEST);
+        BIND_ENUM_CONSTANT(OVERFLOW_POLICY_TIME_STRETCH);
+
+        BIND_ENUM_CONSTANT(RESAMPLER_QUALITY_LINEAR);
+        BIND_ENUM_CONSTANT(RESAMPLER_QUALITY_STANDARD);
+        BIND_ENUM_CONSTANT(RESAMPLER_QUALITY_HIGH);
+
+        BIND_ENUM_CONSTANT(SHARE_MODE_SHARED);
+        BIND_ENUM_CONSTANT(SHARE_MODE_EXCLUSIVE);
+
+        BIND_ENUM_CONSTANT(PERFORMANCE_PROFILE_LOW_LATENCY);
+        BIND_ENUM_CONSTANT(PERFORMANCE_PROFILE_CONSERVATIVE);
+
+        BIND_ENUM_CONSTANT(PERIOD_MODE_DEFAULT);
+        BIND_ENUM_CONSTANT(PERIOD_MODE_FIXED);
+        BIND_ENUM_CONSTANT(PERIOD_MODE_CALIBRATED);
+
+        BIND_ENUM_CONSTANT(ROUTING_BROADCAST);
+        BIND_ENUM_CONSTANT(ROUTING_SELECTED_CONTROLLERS);
+
+        BIND_ENUM_CONSTANT(CLIP_CHANNEL_BOTH);
+        BIND_ENUM_CONSTANT(CLIP_CHANNEL_LEFT);
+        BIND_ENUM_CONSTANT(CLIP_CHANNEL_RIGHT);
+
+        BIND_ENUM_CONSTANT(FILTER_MODE_DISABLED);
+        BIND_ENUM_CONSTANT(FILTER_MODE_LOW_PASS);
+        BIND_ENUM_CONSTANT(FILTER_MODE_BAND_PASS);
+    }
 } // namespace hd_haptics
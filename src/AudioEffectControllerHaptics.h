@@ -3,17 +3,225 @@
 #include <godot_cpp/classes/node.hpp>
 #include <godot_cpp/classes/wrapped.hpp>
 #include <godot_cpp/core/class_db.hpp>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
+#include "HapticsClip.h"
+#include "HapticsConditioner.h"
+#include "HapticsHub.h"
+#include "HapticsStream.h"
 #include "godot_cpp/classes/audio_effect.hpp"
+#include "godot_cpp/classes/audio_stream_wav.hpp"
 
 namespace hd_haptics {
     class AudioEffectControllerHaptics : public godot::AudioEffect {
         GDCLASS(AudioEffectControllerHaptics, AudioEffect)
 
     public:
+        enum OverflowPolicy {
+            OVERFLOW_POLICY_DROP_OLDEST,
+            OVERFLOW_POLICY_TIME_STRETCH,
+        };
+
+        enum ResamplerQuality {
+            RESAMPLER_QUALITY_LINEAR,
+            RESAMPLER_QUALITY_STANDARD,
+            RESAMPLER_QUALITY_HIGH,
+        };
+
+        enum ShareMode {
+            SHARE_MODE_SHARED,
+            SHARE_MODE_EXCLUSIVE,
+        };
+
+        enum PerformanceProfile {
+            PERFORMANCE_PROFILE_LOW_LATENCY,
+            PERFORMANCE_PROFILE_CONSERVATIVE,
+        };
+
+        enum PeriodMode {
+            PERIOD_MODE_DEFAULT,
+            PERIOD_MODE_FIXED,
+            PERIOD_MODE_CALIBRATED,
+        };
+
+        enum Routing {
+            ROUTING_BROADCAST,
+            ROUTING_SELECTED_CONTROLLERS,
+        };
+
+        enum ClipChannel {
+            CLIP_CHANNEL_BOTH,
+            CLIP_CHANNEL_LEFT,
+            CLIP_CHANNEL_RIGHT,
+        };
+
+        enum FilterMode {
+            FILTER_MODE_DISABLED,
+            FILTER_MODE_LOW_PASS,
+            FILTER_MODE_BAND_PASS,
+        };
+
         godot::Ref<godot::AudioEffectInstance> _instantiate() override;
 
+        void set_target_latency_ms(double p_target_latency_ms);
+        [[nodiscard]] double get_target_latency_ms() const;
+
+        void set_overflow_policy(OverflowPolicy p_overflow_policy);
+        [[nodiscard]] OverflowPolicy get_overflow_policy() const;
+
+        void set_resampler_quality(ResamplerQuality p_resampler_quality);
+        [[nodiscard]] ResamplerQuality get_resampler_quality() const;
+
+        /// The device properties are process-wide. All effects share the devices, which are opened with the settings of
+        /// the most recently instantiated effect; instantiating one with different settings while others are active warns.
+        void set_device_share_mode(ShareMode p_device_share_mode);
+        [[nodiscard]] ShareMode get_device_share_mode() const;
+
+        void set_device_performance_profile(PerformanceProfile p_device_performance_profile);
+        [[nodiscard]] PerformanceProfile get_device_performance_profile() const;
+
+        void set_device_period_mode(PeriodMode p_device_period_mode);
+        [[nodiscard]] PeriodMode get_device_period_mode() const;
+
+        void set_device_period_ms(int64_t p_device_period_ms);
+        [[nodiscard]] int64_t get_device_period_ms() const;
+
+        /// How the hub opens devices, from the device properties.
+        [[nodiscard]] HapticsHub::DeviceSettings get_device_settings() const;
+
+        void set_idle_timeout_ms(double p_idle_timeout_ms);
+        [[nodiscard]] double get_idle_timeout_ms() const;
+
+        void set_pass_through(bool p_pass_through);
+        [[nodiscard]] bool is_pass_through() const;
+
+        void set_routing(Routing p_routing);
+        [[nodiscard]] Routing get_routing() const;
+
+        void set_controllers(int64_t p_controllers);
+        [[nodiscard]] int64_t get_controllers() const;
+
+        void set_left_gain(float p_left_gain);
+        [[nodiscard]] float get_left_gain() const;
+
+        void set_right_gain(float p_right_gain);
+        [[nodiscard]] float get_right_gain() const;
+
+        void set_priority(int64_t p_priority);
+        [[nodiscard]] int64_t get_priority() const;
+
+        void set_ducking_db(float p_ducking_db);
+        [[nodiscard]] float get_ducking_db() const;
+
+        void set_dc_blocker(bool p_dc_blocker);
+        [[nodiscard]] bool get_dc_blocker() const;
+
+        void set_filter_mode(FilterMode p_filter_mode);
+        [[nodiscard]] FilterMode get_filter_mode() const;
+
+        void set_filter_cutoff_hz(float p_filter_cutoff_hz);
+        [[nodiscard]] float get_filter_cutoff_hz() const;
+
+        void set_filter_resonance(float p_filter_resonance);
+        [[nodiscard]] float get_filter_resonance() const;
+
+        void set_compressor_enabled(bool p_compressor_enabled);
+        [[nodiscard]] bool get_compressor_enabled() const;
+
+        void set_compressor_threshold_db(float p_compressor_threshold_db);
+        [[nodiscard]] float get_compressor_threshold_db() const;
+
+        void set_compressor_ratio(float p_compressor_ratio);
+        [[nodiscard]] float get_compressor_ratio() const;
+
+        void set_compressor_attack_ms(float p_compressor_attack_ms);
+        [[nodiscard]] float get_compressor_attack_ms() const;
+
+        void set_compressor_release_ms(float p_compressor_release_ms);
+        [[nodiscard]] float get_compressor_release_ms() const;
+
+        void set_compressor_ceiling_db(float p_compressor_ceiling_db);
+        [[nodiscard]] float get_compressor_ceiling_db() const;
+
+        [[nodiscard]] const HapticsConditioner::Settings& get_conditioner_settings() const {
+            return m_conditioner_settings;
+        }
+
+        /// Bit mask of the controllers the audio of this effect is played on.
+        [[nodiscard]] uint32_t get_controller_mask() const;
+
+        /// Indices of the currently connected controllers, usable as bits of `controllers`.
+        static godot::Array get_connected_controllers();
+
+        /// Records what every controller plays, after mixing and before the channel conversion, to a capture file.
+        static bool start_capture(const godot::String& p_path);
+        static void stop_capture();
+        static bool is_capturing();
+
+        /// Plays what `p_source_controller` played in a capture file on every connected controller, without any bus.
+        static bool start_replay(const godot::String& p_path, int64_t p_source_controller);
+        static void stop_replay();
+        static bool is_replaying();
+
+        /// Decodes a clip ahead of time, so the first play_clip() call doesn't have to.
+        bool preload_clip(const godot::Ref<godot::AudioStreamWAV>& p_clip);
+
+        /// Plays a clip directly in the device callback, bypassing the audio bus and the ring buffer latency.
+        /// `p_controllers` is a bit mask of controllers, or -1 to use the routing of this effect.
+        bool play_clip(const godot::Ref<godot::AudioStreamWAV>& p_clip, float p_gain, ClipChannel p_channel, int64_t p_controllers);
+        void stop_clips();
+
     protected:
+        double m_target_latency_ms = 40.0;
+        OverflowPolicy m_overflow_policy = OVERFLOW_POLICY_DROP_OLDEST;
+        ResamplerQuality m_resampler_quality = RESAMPLER_QUALITY_STANDARD;
+        ShareMode m_device_share_mode = SHARE_MODE_SHARED;
+        PerformanceProfile m_device_performance_profile = PERFORMANCE_PROFILE_LOW_LATENCY;
+        PeriodMode m_device_period_mode = PERIOD_MODE_DEFAULT;
+        int64_t m_device_period_ms = 10;
+        double m_idle_timeout_ms = 5000.0;
+        bool m_pass_through = false;
+        Routing m_routing = ROUTING_BROADCAST;
+        int64_t m_controllers = 1;
+        float m_left_gain = 1.0f;
+        float m_right_gain = 1.0f;
+        int64_t m_priority = 0;
+        float m_ducking_db = -12.0f;
+        HapticsConditioner::Settings m_conditioner_settings;
+
+        struct RetiredClip {
+            std::unique_ptr<HapticsClip> clip;
+            std::chrono::steady_clock::time_point release_time;
+        };
+
+        // Guards the clip cache and pushing clip commands. Clips are cached by the instance id of their stream. Once
+        // the stream is freed, the clip is retired until no voice can be playing it anymore. The effect outlives its
+        // instances and thereby every voice, so whatever is left is freed with it.
+        std::mutex m_clip_mutex;
+        std::unordered_map<uint64_t, std::unique_ptr<HapticsClip>> m_clip_cache;
+        std::vector<RetiredClip> m_retired_clips;
+        std::weak_ptr<HapticsStream> m_current_stream;
+
+        /// Returns the cached clip, decoding it first without holding m_clip_mutex. Must be called with `lock` held.
+        const HapticsClip* get_or_decode_clip(const godot::Ref<godot::AudioStreamWAV>& p_clip, std::unique_lock<std::mutex>& lock);
+        static std::unique_ptr<HapticsClip> decode_clip(const godot::Ref<godot::AudioStreamWAV>& p_clip);
+        /// Retires the clips of freed streams and frees the retired clips that are no longer played. Must be called
+        /// with m_clip_mutex held.
+        void prune_clip_cache();
+
         static void _bind_methods();
     };
 } // namespace hd_haptics
+
+VARIANT_ENUM_CAST(hd_haptics::AudioEffectControllerHaptics::OverflowPolicy);
+VARIANT_ENUM_CAST(hd_haptics::AudioEffectControllerHaptics::ResamplerQuality);
+VARIANT_ENUM_CAST(hd_haptics::AudioEffectControllerHaptics::ShareMode);
+VARIANT_ENUM_CAST(hd_haptics::AudioEffectControllerHaptics::PerformanceProfile);
+VARIANT_ENUM_CAST(hd_haptics::AudioEffectControllerHaptics::PeriodMode);
+VARIANT_ENUM_CAST(hd_haptics::AudioEffectControllerHaptics::Routing);
+VARIANT_ENUM_CAST(hd_haptics::AudioEffectControllerHaptics::ClipChannel);
+VARIANT_ENUM_CAST(hd_haptics::AudioEffectControllerHaptics::FilterMode);
@@ -1,270 +1,233 @@
 #include "AudioEffectControllerHapticsInstance.h"
 
-#include <format>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <utility>
+#include <vector>
 #include <godot_cpp/classes/engine.hpp>
 
-#define MINIAUDIO_IMPLEMENTATION
-#include "external/miniaudio_init.h"
-
-
 #include "godot_cpp/classes/audio_server.hpp"
-
-#define HANDLE_MA_ERROR(ma_result)                                                                                                                             \
-    if (ma_result != MA_SUCCESS) {                                                                                                                             \
-        uninitialize_miniaudio();                                                                                                                              \
-        ERR_FAIL_MSG(std::format("miniaudio: {}", ma_result_description(result)).c_str());                                                                     \
-    }
+#include "godot_cpp/classes/performance.hpp"
 
 namespace hd_haptics {
-    constexpr int INPUT_CHANNELS = 2;
-    constexpr int OUTPUT_CHANNELS = 4;
+    // Monitor id and the get_stats() key it shows
+    constexpr std::array<std::pair<const char*, const char*>, 6> PERFORMANCE_MONITORS = {{
+        {"Controller Haptics/Latency (ms)", "latency_ms"},
+        {"Controller Haptics/Buffer Fill (ms)", "fill_level_ms"},
+        {"Controller Haptics/Callback p99 (us)", "callback_p99_us"},
+        {"Controller Haptics/Underruns", "underruns"},
+        {"Controller Haptics/Overruns", "overruns"},
+        {"Controller Haptics/Dropped Frames", "dropped_frames"},
+    }};
+
+    // Every live instance in creation order, and the one whose stats the performance monitors show. Only touched
+    // from the main thread.
+    static std::vector<AudioEffectControllerHapticsInstance*> monitored_instances;
+    static AudioEffectControllerHapticsInstance* monitor_owner = nullptr;
+
+    AudioEffectControllerHapticsInstance::AudioEffectControllerHapticsInstance() = default;
+
+    void AudioEffectControllerHapticsInstance::initialize() {
+        auto* hub = HapticsHub::get_singleton();
+        ERR_FAIL_NULL(hub);
+
+        const auto sample_rate = static_cast<uint32_t>(godot::AudioServer::get_singleton()->get_mix_rate());
+
+        HapticsStream::Config config;
+        config.sample_rate = sample_rate;
+        config.target_frames = static_cast<uint32_t>(base->get_target_latency_ms() * sample_rate / 1000.0);
+        config.time_stretch = base->get_overflow_policy() == AudioEffectControllerHaptics::OVERFLOW_POLICY_TIME_STRETCH;
+        config.resampler_quality = static_cast<PolyphaseResampler::Quality>(base->get_resampler_quality());
+
+        m_stream = std::make_shared<HapticsStream>(config);
+        m_stream->set_controller_mask(base->get_controller_mask());
+
+        m_writer.initialize(m_stream);
+
+        // Like clips and monitors, the device settings follow the most recent instance
+        hub->set_device_settings(base->get_device_settings());
+
+        // The hub opens the devices on the device manager thread, _process discards audio until the first one is live
+        m_lane = hub->add_lane(m_stream, [base = base](int controller_index, bool connected) {
+            base->call_deferred("emit_signal", connected ? "controller_connected" : "controller_disconnected", controller_index);
+        });
 
-    std::optional<ma_context> context;
+        register_monitors();
+    }
 
-    std::optional<ma_device_id> get_dualsense_audio_device_id() {
-        ma_device_info* playback_device_infos;
-        ma_uint32 playback_device_count;
+    void AudioEffectControllerHapticsInstance::register_monitors() {
+        monitored_instances.push_back(this);
 
-        constexpr std::array backends = {
-            ma_backend_pulseaudio,
-            ma_backend_wasapi,
-        };
+        // Like clips, the monitors follow the most recent instance
+        show_monitors();
+    }
 
-        if (!context.has_value()) {
-            context = std::make_optional<ma_context>();
+    void AudioEffectControllerHapticsInstance::show_monitors() {
+        auto* performance = godot::Performance::get_singleton();
+        ERR_FAIL_NULL(performance);
 
-            if (ma_context_init(backends.data(), static_cast<ma_uint32>(backends.size()), nullptr, &*context) != MA_SUCCESS) {
-                ma_context_uninit(&*context);
-                context = std::nullopt;
-                ERR_FAIL_V_MSG(std::nullopt, "Failed to initialize context.");
+        for (const auto& [monitor_id, stat] : PERFORMANCE_MONITORS) {
+            if (performance->has_custom_monitor(monitor_id)) {
+                performance->remove_custom_monitor(monitor_id);
             }
-        }
 
-        ma_result result = ma_context_get_devices(&*context, &playback_device_infos, &playback_device_count, nullptr, nullptr);
-        if (result != MA_SUCCESS) {
-            ma_context_uninit(&*context);
-            context = std::nullopt;
-            ERR_FAIL_V_MSG(std::nullopt, "Failed to retrieve device information");
+            godot::Array arguments;
+            arguments.push_back(stat);
+            performance->add_custom_monitor(monitor_id, godot::Callable(this, "get_stat"), arguments);
         }
 
-        for (ma_uint32 i_device = 0; i_device < playback_device_count; ++i_device) {
-            const auto playback_device_info = playback_device_infos[i_device];
-            std::string name(playback_device_info.name);
-            if (name.contains("DualSense")) {
-                return playback_device_info.id;
-            }
-        }
-
-        return std::nullopt;
+        monitor_owner = this;
     }
 
-    void AudioEffectControllerHapticsInstance::output_data_callback(ma_device* p_device, void* output, const void* input, ma_uint32 p_frame_count) {
-        const auto instance = static_cast<AudioEffectControllerHapticsInstance*>(p_device->pUserData);
-
-        ma_uint32 frames_written = 0;
-
-        while (frames_written < p_frame_count) {
-            void* p_mapped_buffer;
-            ma_uint32 frames_to_write = p_frame_count - frames_written;
-
-            ma_result result = ma_pcm_rb_acquire_read(&*instance->m_ring_buffer, &frames_to_write, &p_mapped_buffer);
-
-            if (result != MA_SUCCESS) {
-                break;
-            }
+    void AudioEffectControllerHapticsInstance::unregister_monitors() {
+        std::erase(monitored_instances, this);
 
-            if (frames_to_write == 0) {
-                break;
-            }
-
-            result = ma_channel_converter_process_pcm_frames(&*instance->m_channel_converter, output, p_mapped_buffer, frames_to_write);
-            if (result != MA_SUCCESS) {
-                break;
-            }
-
-            result = ma_pcm_rb_commit_read(&*instance->m_ring_buffer, frames_to_write);
-            if (result != MA_SUCCESS) {
-                break;
-            }
-
-            frames_written += frames_to_write;
+        if (monitor_owner != this) {
+            return;
         }
-    }
 
-    void AudioEffectControllerHapticsInstance::device_notification_callback(const ma_device_notification* notification) {
-        const auto instance = static_cast<AudioEffectControllerHapticsInstance*>(notification->pDevice->pUserData);
-
-        if (notification->type == ma_device_notification_type_stopped) {
-            instance->uninitialize_miniaudio();
+        // Hand the monitors to the most recent instance still alive, so the profiler keeps its data
+        if (!monitored_instances.empty()) {
+            monitored_instances.back()->show_monitors();
+            return;
         }
-    }
-
-    AudioEffectControllerHapticsInstance::AudioEffectControllerHapticsInstance() {
-        // First time initialization
-        {
-            auto device_id = get_dualsense_audio_device_id();
 
-            if (device_id.has_value()) {
-                try_initialize_miniaudio(*device_id);
-            } else {
-                WARN_PRINT("Did not find a compatible Audio Haptics device");
+        if (auto* performance = godot::Performance::get_singleton()) {
+            for (const auto& [monitor_id, stat] : PERFORMANCE_MONITORS) {
+                if (performance->has_custom_monitor(monitor_id)) {
+                    performance->remove_custom_monitor(monitor_id);
+                }
             }
         }
 
-        m_device_availability_check = std::thread([this] {
-            while (!m_stop_device_availability_check) {
-                {
-                    std::unique_lock lock(m_initialization_mutex, std::try_to_lock);
-
-                    if (lock.owns_lock()) {
-                        auto device_id = get_dualsense_audio_device_id();
-
-                        if (m_device.has_value()) {
-                            // This memcmp is safe: https://github.com/mackron/miniaudio/issues/866#issuecomment-2207374206
-                            if (!device_id.has_value() ||
-                                std::memcmp(&m_device->playback.id, &*device_id, 256) != 0) { // NOLINT(*-suspicious-memory-comparison)
-                                uninitialize_miniaudio();
-                                WARN_PRINT("Audio Haptics device disconnected");
-                            }
-                        } else if (device_id.has_value()) {
-                            try_initialize_miniaudio(*device_id);
-                            WARN_PRINT("Audio Haptics device connected");
-                        }
-                    }
-                }
-
-                // Sleep for 1s
-                for (int i = 0; i < 100 && !m_stop_device_availability_check; ++i) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                }
-            }
-        });
+        monitor_owner = nullptr;
     }
 
     AudioEffectControllerHapticsInstance::~AudioEffectControllerHapticsInstance() {
-        m_stop_device_availability_check = true;
-        m_device_availability_check.join();
+        unregister_monitors();
 
-        uninitialize_miniaudio();
+        if (auto* hub = HapticsHub::get_singleton(); hub != nullptr && m_lane.has_value()) {
+            hub->remove_lane(*m_lane);
+        }
     }
 
     void AudioEffectControllerHapticsInstance::_process(const void* p_src_buffer, godot::AudioFrame* p_dst_buffer, int32_t p_frame_count) {
-        if (!m_ring_buffer.has_value()) {
-            return;
+        // Godot hands out separate source and destination buffers, so the bus output is either a straight copy of
+        // the block or silence. The send below reads the source block, its gains and conditioning never reach the bus.
+        const size_t block_size = static_cast<size_t>(p_frame_count) * sizeof(godot::AudioFrame);
+        if (base->is_pass_through()) {
+            std::memcpy(p_dst_buffer, p_src_buffer, block_size);
+        } else {
+            std::memset(p_dst_buffer, 0, block_size);
         }
 
-        std::unique_lock lock(m_initialization_mutex, std::try_to_lock);
-
-        if (!lock.owns_lock()) {
+        if (m_stream == nullptr) {
             return;
         }
 
-        /* We need to write to the ring buffer. Need to do this in a loop. */
-        int32_t frames_written = 0;
-
-        while (frames_written < p_frame_count) {
-            void* p_mapped_buffer;
-            ma_uint32 frames_to_write = p_frame_count - frames_written;
-
-            ma_result result = ma_pcm_rb_acquire_write(&*m_ring_buffer, &frames_to_write, &p_mapped_buffer);
-            if (result != MA_SUCCESS) {
-                break;
-            }
-
-            if (frames_to_write == 0) {
-                break;
-            }
-
-            /* Copy the data from the capture buffer to the ring buffer. */
-            ma_copy_pcm_frames(
-                p_mapped_buffer,
-                ma_offset_pcm_frames_const_ptr_f32(static_cast<const float*>(p_src_buffer), frames_written, INPUT_CHANNELS),
-                frames_to_write,
-                ma_format_f32,
-                INPUT_CHANNELS
-            );
-
-            result = ma_pcm_rb_commit_write(&*m_ring_buffer, frames_to_write);
+        // Nothing reads the stream until a device is live, and a device starts reading at the newest frame anyway
+        if (!m_stream->is_live()) {
+            return;
+        }
 
-            if (result != MA_SUCCESS) {
-                break;
-            }
+        // Routing and gain changes from script take effect with the next block
+        m_stream->set_controller_mask(base->get_controller_mask());
+        m_stream->set_channel_gains(base->get_left_gain(), base->get_right_gain());
+        m_stream->set_idle_timeout(std::chrono::milliseconds(static_cast<int64_t>(base->get_idle_timeout_ms())));
+        m_stream->set_mix_priority(static_cast<int>(base->get_priority()), std::pow(10.0f, base->get_ducking_db() / 20.0f));
 
-            frames_written += static_cast<int32_t>(frames_to_write);
-        }
+        m_writer.set_conditioner_settings(base->get_conditioner_settings());
+        m_writer.write(static_cast<const float*>(p_src_buffer), static_cast<uint32_t>(p_frame_count));
     }
 
     bool AudioEffectControllerHapticsInstance::_process_silence() const {
         return true;
     }
 
-    void AudioEffectControllerHapticsInstance::try_initialize_miniaudio(const ma_device_id& device_id) {
-        auto sample_rate = static_cast<uint32_t>(godot::AudioServer::get_singleton()->get_mix_rate());
-
-        m_ring_buffer = std::make_optional<ma_pcm_rb>();
-
-        ma_result result;
+    int64_t AudioEffectControllerHapticsInstance::get_dropped_frame_count() const {
+        return m_stream != nullptr ? static_cast<int64_t>(m_stream->get_stats().get_dropped_frames()) : 0;
+    }
 
-        result = ma_pcm_rb_init(ma_format_f32, INPUT_CHANNELS, 1024 * 5000, nullptr, nullptr, &*m_ring_buffer);
-        HANDLE_MA_ERROR(result);
+    godot::Dictionary AudioEffectControllerHapticsInstance::get_stats() const {
+        godot::Dictionary stats;
 
-        m_ring_buffer->sampleRate = sample_rate;
+        if (m_stream == nullptr) {
+            return stats;
+        }
 
-        ma_channel device_output_map[OUTPUT_CHANNELS] = {MA_CHANNEL_FRONT_LEFT, MA_CHANNEL_FRONT_RIGHT, MA_CHANNEL_BACK_LEFT, MA_CHANNEL_BACK_RIGHT};
+        const HapticsStats::Snapshot snapshot = m_stream->get_stats().get_snapshot();
+        const double frames_to_ms = 1000.0 / m_stream->get_config().sample_rate;
+
+        stats["fill_level_ms"] = snapshot.fill_level_frames * frames_to_ms;
+        stats["latency_ms"] = snapshot.latency_frames * frames_to_ms;
+        stats["device_period_frames"] = snapshot.device_period_frames;
+        stats["callbacks"] = static_cast<int64_t>(snapshot.callbacks);
+        stats["callback_p50_us"] = static_cast<double>(snapshot.callback_p50_ns) / 1000.0;
+        stats["callback_p95_us"] = static_cast<double>(snapshot.callback_p95_ns) / 1000.0;
+        stats["callback_p99_us"] = static_cast<double>(snapshot.callback_p99_ns) / 1000.0;
+        stats["callback_max_us"] = static_cast<double>(snapshot.callback_max_ns) / 1000.0;
+        stats["underruns"] = static_cast<int64_t>(snapshot.underruns);
+        stats["overruns"] = static_cast<int64_t>(snapshot.overruns);
+        stats["dropped_frames"] = static_cast<int64_t>(snapshot.dropped_frames);
+        stats["skipped_silent_frames"] = static_cast<int64_t>(snapshot.skipped_silent_frames);
+        stats["devices_connected"] = static_cast<int64_t>(snapshot.devices_connected);
+        stats["devices_disconnected"] = static_cast<int64_t>(snapshot.devices_disconnected);
+        stats["suspend_count"] = get_suspend_count();
+        stats["wake_up_count"] = get_wake_up_count();
+
+        return stats;
+    }
 
-        ma_device_config device_config = ma_device_config_init(ma_device_type_playback);
-        device_config.sampleRate = sample_rate;
-        device_config.performanceProfile = ma_performance_profile_low_latency;
-        device_config.noPreSilencedOutputBuffer = MA_TRUE;
-        device_config.noClip = MA_TRUE;
-        device_config.noFixedSizedCallback = MA_TRUE;
-        device_config.playback.format = ma_format_f32;
-        device_config.playback.channels = OUTPUT_CHANNELS;
-        device_config.playback.pChannelMap = device_output_map;
-        device_config.playback.shareMode = ma_share_mode_shared;
-        device_config.pUserData = this;
-        device_config.dataCallback = output_data_callback;
-        device_config.notificationCallback = device_notification_callback;
-        device_config.playback.pDeviceID = &device_id;
+    godot::Variant AudioEffectControllerHapticsInstance::get_stat(const godot::String& p_stat) const {
+        // Every monitor asks for one entry each frame, and collecting them computes the percentiles every time
+        const uint64_t frame = godot::Engine::get_singleton()->get_process_frames();
+        if (m_frame_stats_frame != frame) {
+            m_frame_stats = get_stats();
+            m_frame_stats_frame = frame;
+        }
 
-#if defined(MA_HAS_PULSEAUDIO)
-        device_config.pulse.channelMap = MA_PA_CHANNEL_MAP_ALSA;
-        device_config.pulse.blockingMainLoop = MA_FALSE;
-#endif
+        return m_frame_stats.get(p_stat, godot::Variant());
+    }
 
-        m_device = std::make_optional<ma_device>();
-        result = ma_device_init(nullptr, &device_config, &*m_device);
-        HANDLE_MA_ERROR(result);
+    void AudioEffectControllerHapticsInstance::reset_stats() {
+        m_frame_stats_frame = std::nullopt;
 
-        constexpr ma_channel input_map[INPUT_CHANNELS] = {MA_CHANNEL_BACK_LEFT, MA_CHANNEL_BACK_RIGHT};
-        constexpr ma_channel output_map[OUTPUT_CHANNELS] = {MA_CHANNEL_FRONT_LEFT, MA_CHANNEL_FRONT_RIGHT, MA_CHANNEL_BACK_LEFT, MA_CHANNEL_BACK_RIGHT};
-        ma_channel_converter_config converter_config = ma_channel_converter_config_init(
-            ma_format_f32, INPUT_CHANNELS, input_map, OUTPUT_CHANNELS, output_map, ma_channel_mix_mode_simple
-        );
+        if (m_stream != nullptr) {
+            m_stream->get_stats().reset();
+        }
+    }
 
-        m_channel_converter = std::make_optional<ma_channel_converter>();
-        result = ma_channel_converter_init(&converter_config, nullptr, &*m_channel_converter);
-        HANDLE_MA_ERROR(result);
+    int64_t AudioEffectControllerHapticsInstance::get_suspend_count() const {
+        auto* hub = HapticsHub::get_singleton();
+        return hub != nullptr ? static_cast<int64_t>(hub->get_suspend_count()) : 0;
+    }
 
-        ma_device_start(&*m_device);
+    int64_t AudioEffectControllerHapticsInstance::get_wake_up_count() const {
+        auto* hub = HapticsHub::get_singleton();
+        return hub != nullptr ? static_cast<int64_t>(hub->get_wake_up_count()) : 0;
     }
 
-    void AudioEffectControllerHapticsInstance::uninitialize_miniaudio() {
-        if (m_device.has_value()) {
-            ma_device_uninit(&*m_device);
-            m_device = std::nullopt;
-        }
+    godot::Array AudioEffectControllerHapticsInstance::get_open_controllers() {
+        godot::Array controllers;
 
-        if (m_channel_converter.has_value()) {
-            ma_channel_converter_uninit(&*m_channel_converter, nullptr);
-            m_channel_converter = std::nullopt;
+        if (auto* hub = HapticsHub::get_singleton()) {
+            for (const int controller_index : hub->get_open_controllers()) {
+                controllers.push_back(controller_index);
+            }
         }
 
-        if (m_ring_buffer.has_value()) {
-            ma_pcm_rb_uninit(&*m_ring_buffer);
-            m_ring_buffer = std::nullopt;
-        }
+        return controllers;
     }
 
-    void AudioEffectControllerHapticsInstance::_bind_methods() {}
+    void AudioEffectControllerHapticsInstance::_bind_methods() {
+        godot::ClassDB::bind_method(godot::D_METHOD("get_dropped_frame_count"), &AudioEffectControllerHapticsInstance::get_dropped_frame_count);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_stats"), &AudioEffectControllerHapticsInstance::get_stats);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_stat", "stat"), &AudioEffectControllerHapticsInstance::get_stat);
+        godot::ClassDB::bind_method(godot::D_METHOD("reset_stats"), &AudioEffectControllerHapticsInstance::reset_stats);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_suspend_count"), &AudioEffectControllerHapticsInstance::get_suspend_count);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_wake_up_count"), &AudioEffectControllerHapticsInstance::get_wake_up_count);
+        godot::ClassDB::bind_method(godot::D_METHOD("get_open_controllers"), &AudioEffectControllerHapticsInstance::get_open_controllers);
+    }
 } // namespace hd_haptics
@@ -8,8 +8,10 @@
 #include <optional>
 #include "AudioEffectControllerHaptics.h"
 
-#include <thread>
-#include "external/miniaudio_init.h"
+#include <memory>
+#include "HapticsHub.h"
+#include "HapticsStream.h"
+#include "HapticsStreamWriter.h"
 
 namespace hd_haptics {
     class AudioEffectControllerHapticsInstance : public godot::AudioEffectInstance {
@@ -24,20 +26,42 @@ namespace hd_haptics {
         void _process(const void* p_src_buffer, godot::AudioFrame* p_dst_buffer, int32_t p_frame_count) override;
         bool _process_silence() const override;
 
+        [[nodiscard]] int64_t get_dropped_frame_count() const;
+
+        /// Buffer levels, latency, callback timing and event counters of this instance.
+        [[nodiscard]] godot::Dictionary get_stats() const;
+
+        /// A single entry of get_stats(), used by the performance monitors. The stats are collected once per frame.
+        [[nodiscard]] godot::Variant get_stat(const godot::String& p_stat) const;
+
+        /// Clears the callback timing and event counters.
+        void reset_stats();
+
+        /// How often the devices were stopped after the idle timeout, and started again when audio came back.
+        [[nodiscard]] int64_t get_suspend_count() const;
+        [[nodiscard]] int64_t get_wake_up_count() const;
+
+        /// Indices of the controllers a device is currently open for. Devices are shared by all instances.
+        [[nodiscard]] godot::Array get_open_controllers();
+
     protected:
-        std::optional<ma_pcm_rb> m_ring_buffer = std::nullopt;
-        std::optional<ma_device> m_device = std::nullopt;
-        std::optional<ma_channel_converter> m_channel_converter = std::nullopt;
+        // Written once per block by _process and mixed by every open device of the hub. The audio thread never
+        // touches the devices themselves, so opening and closing them never blocks it.
+        std::shared_ptr<HapticsStream> m_stream;
+        HapticsStreamWriter m_writer;
+
+        std::optional<HapticsHub::LaneId> m_lane = std::nullopt;
 
-        std::atomic<bool> m_stop_device_availability_check = false;
-        std::thread m_device_availability_check;
-        std::mutex m_initialization_mutex;
+        // get_stats() of the last frame get_stat() was called in, shared by the performance monitors
+        mutable godot::Dictionary m_frame_stats;
+        mutable std::optional<uint64_t> m_frame_stats_frame = std::nullopt;
 
-        void try_initialize_miniaudio(const ma_device_id& device_id);
-        void uninitialize_miniaudio();
+        void initialize();
+        void register_monitors();
+        /// Points the performance monitors at this instance.
+        void show_monitors();
+        void unregister_monitors();
 
-        static void output_data_callback(ma_device* p_device, void* output, const void* input, ma_uint32 p_frame_count);
-        static void device_notification_callback(const ma_device_notification* notification);
         static void _bind_methods();
     };
 } // namespace hd_haptics
@@ -0,0 +1,59 @@
+#include "BroadcastRingBuffer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace hd_haptics {
+    void BroadcastRingBuffer::Reader::attach(const BroadcastRingBuffer& buffer) {
+        m_buffer = &buffer;
+        m_read_position = buffer.m_write_position.load(std::memory_order_acquire);
+    }
+
+    uint32_t BroadcastRingBuffer::Reader::available(uint64_t& r_dropped_frames) {
+        const uint64_t write_position = m_buffer->m_write_position.load(std::memory_order_acquire);
+        const uint64_t distance = write_position - m_read_position;
+
+        if (distance > m_buffer->m_readable_frames) {
+            r_dropped_frames += distance - m_buffer->m_readable_frames;
+            m_read_position = write_position - m_buffer->m_readable_frames;
+            return m_buffer->m_readable_frames;
+        }
+
+        return static_cast<uint32_t>(distance);
+    }
+
+    const float* BroadcastRingBuffer::Reader::map(uint32_t& r_frame_count) const {
+        const auto offset = static_cast<uint32_t>(m_read_position & (m_buffer->m_capacity - 1));
+        r_frame_count = std::min(r_frame_count, m_buffer->m_capacity - offset);
+        return m_buffer->m_samples.data() + static_cast<size_t>(offset) * CHANNELS;
+    }
+
+    void BroadcastRingBuffer::initialize(uint32_t readable_frames, uint32_t block_frames) {
+        // A power of two capacity turns the wrap around into a mask
+        m_capacity = std::bit_ceil(readable_frames + block_frames);
+        m_readable_frames = m_capacity - block_frames;
+        m_block_frames = block_frames;
+        m_samples.assign(static_cast<size_t>(m_capacity) * CHANNELS, 0.0f);
+        m_write_position.store(0, std::memory_order_release);
+    }
+
+    void BroadcastRingBuffer::write(const float* p_frames, uint32_t frame_count) {
+        uint64_t write_position = m_write_position.load(std::memory_order_relaxed);
+
+        while (frame_count > 0) {
+            const uint32_t block_frames = std::min(frame_count, m_block_frames);
+            const auto offset = static_cast<uint32_t>(write_position & (m_capacity - 1));
+            const uint32_t first_frames = std::min(block_frames, m_capacity - offset);
+
+            std::memcpy(m_samples.data() + static_cast<size_t>(offset) * CHANNELS, p_frames, first_frames * CHANNELS * sizeof(float));
+            std::memcpy(m_samples.data(), p_frames + first_frames * CHANNELS, (block_frames - first_frames) * CHANNELS * sizeof(float));
+
+            write_position += block_frames;
+            m_write_position.store(write_position, std::memory_order_release);
+
+            p_frames += block_frames * CHANNELS;
+            frame_count -= block_frames;
+        }
+    }
+} // namespace hd_haptics
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace hd_haptics {
+    /// Single producer ring buffer of interleaved stereo frames that any number of consumers can read
+    /// independently, each through its own Reader. The producer never waits for consumers: it keeps
+    /// overwriting the oldest frames, and a consumer that fell behind by more than the readable window
+    /// skips ahead. This lets one capture in `_process` feed several devices with a single copy.
+    class BroadcastRingBuffer {
+    public:
+        static constexpr int CHANNELS = 2;
+
+        class Reader {
+        public:
+            /// Starts reading at the current write position of `buffer`.
+            void attach(const BroadcastRingBuffer& buffer);
+
+            /// Number of frames that can be read. If the producer lapped this reader, it skips ahead to the
+            /// oldest readable frame first and adds the lost frames to `r_dropped_frames`.
+            uint32_t available(uint64_t& r_dropped_frames);
+
+            /// Returns a pointer to up to `r_frame_count` contiguous frames at the read position and clamps
+            /// `r_frame_count` to the end of the buffer. Must not exceed available().
+            const float* map(uint32_t& r_frame_count) const;
+
+            /// Advances the read position.
+            void skip(uint32_t frame_count) {
+                m_read_position += frame_count;
+            }
+
+        private:
+            const BroadcastRingBuffer* m_buffer = nullptr;
+            uint64_t m_read_position = 0;
+        };
+
+        /// Allocates room for at least `readable_frames` plus `block_frames`. Writes are split into blocks of
+        /// at most `block_frames`, so frames within the readable window are never overwritten while read.
+        void initialize(uint32_t readable_frames, uint32_t block_frames);
+
+        void write(const float* p_frames, uint32_t frame_count);
+
+        [[nodiscard]] uint32_t get_readable_frames() const {
+            return m_readable_frames;
+        }
+
+    private:
+        std::vector<float> m_samples;
+        uint32_t m_capacity = 0;
+        uint32_t m_readable_frames = 0;
+        uint32_t m_block_frames = 0;
+
+        alignas(64) std::atomic<uint64_t> m_write_position = 0;
+    };
+} // namespace hd_haptics
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "Simd.h"
+
+namespace hd_haptics {
+    /// Marks an output channel that is always silent.
+    constexpr int SILENT_CHANNEL = -1;
+
+    /// Converts interleaved float frames between two fixed channel layouts. `SOURCE_CHANNELS` lists, for every
+    /// output channel, the input channel it is copied from, or SILENT_CHANNEL. Because the layout is known at
+    /// compile time, the conversion boils down to a few shuffles per frame instead of the generic per-sample
+    /// channel mixing of ma_channel_converter.
+    ///
+    /// The stereo to quad layout used for the DualSense (silent front pair, haptics on the back pair) has
+    /// dedicated AVX, SSE2 and NEON kernels; every other layout uses the scalar fallback.
+    template <size_t INPUT_CHANNELS, size_t OUTPUT_CHANNELS, std::array<int, OUTPUT_CHANNELS> SOURCE_CHANNELS>
+    class ChannelConverter {
+    public:
+        using Gains = std::array<float, INPUT_CHANNELS>;
+
+        static void process(float* p_output, const float* p_input, uint32_t frame_count) {
+            convert<false>(p_output, p_input, frame_count, Gains{});
+        }
+
+        /// Same as process(), but scales every input channel by its gain.
+        static void process(float* p_output, const float* p_input, uint32_t frame_count, const Gains& gains) {
+            convert<true>(p_output, p_input, frame_count, gains);
+        }
+
+    private:
+        static constexpr bool IS_STEREO_TO_BACK_PAIR =
+            INPUT_CHANNELS == 2 && OUTPUT_CHANNELS == 4 && SOURCE_CHANNELS == std::array<int, OUTPUT_CHANNELS>{SILENT_CHANNEL, SILENT_CHANNEL, 0, 1};
+
+        template <bool APPLY_GAIN>
+        static void convert(float* p_output, const float* p_input, uint32_t frame_count, const Gains& gains) {
+            uint32_t frame = 0;
+
+            if constexpr (IS_STEREO_TO_BACK_PAIR) {
+                frame = convert_stereo_to_back_pair<APPLY_GAIN>(p_output, p_input, frame_count, gains);
+            }
+
+            convert_scalar<APPLY_GAIN>(p_output, p_input, frame, frame_count, gains);
+        }
+
+        template <bool APPLY_GAIN>
+        static void convert_scalar(float* p_output, const float* p_input, uint32_t first_frame, uint32_t frame_count, const Gains& gains) {
+            for (uint32_t frame = first_frame; frame < frame_count; ++frame) {
+                const float* p_input_frame = p_input + static_cast<size_t>(frame) * INPUT_CHANNELS;
+                float* p_output_frame = p_output + static_cast<size_t>(frame) * OUTPUT_CHANNELS;
+
+                for (size_t channel = 0; channel < OUTPUT_CHANNELS; ++channel) {
+                    constexpr auto source_channels = SOURCE_CHANNELS;
+                    const int source_channel = source_channels[channel];
+
+                    if (source_channel == SILENT_CHANNEL) {
+                        p_output_frame[channel] = 0.0f;
+                    } else if constexpr (APPLY_GAIN) {
+                        p_output_frame[channel] = p_input_frame[source_channel] * gains[source_channel];
+                    } else {
+                        p_output_frame[channel] = p_input_frame[source_channel];
+                    }
+                }
+            }
+        }
+
+        /// Handles the frames that fit the vector width and returns the index of the first frame left over.
+        template <bool APPLY_GAIN>
+        static uint32_t convert_stereo_to_back_pair(float* p_output, const float* p_input, uint32_t frame_count, const Gains& gains) {
+            uint32_t frame = 0;
+
+#if defined(HD_HAPTICS_SIMD_AVX)
+            const __m256 gain = _mm256_setr_ps(gains[0], gains[1], gains[0], gains[1], gains[0], gains[1], gains[0], gains[1]);
+            const __m256d zero = _mm256_setzero_pd();
+
+            // 4 frames per iteration. A stereo frame is moved around as one 64 bit lane.
+            for (; frame + 4 <= frame_count; frame += 4) {
+                __m256 input = _mm256_loadu_ps(p_input + frame * 2);
+                if constexpr (APPLY_GAIN) {
+                    input = _mm256_mul_ps(input, gain);
+                }
+
+                const __m256d pairs = _mm256_castps_pd(input);
+                const __m256d low = _mm256_unpacklo_pd(zero, pairs);  // 0, f0 | 0, f2
+                const __m256d high = _mm256_unpackhi_pd(zero, pairs); // 0, f1 | 0, f3
+
+                _mm256_storeu_ps(p_output + frame * 4, _mm256_castpd_ps(_mm256_permute2f128_pd(low, high, 0x20)));
+                _mm256_storeu_ps(p_output + frame * 4 + 8, _mm256_castpd_ps(_mm256_permute2f128_pd(low, high, 0x31)));
+            }
+#elif defined(HD_HAPTICS_SIMD_SSE2)
+            const __m128 gain = _mm_setr_ps(gains[0], gains[1], gains[0], gains[1]);
+            const __m128 zero = _mm_setzero_ps();
+
+            // 2 frames per iteration
+            for (; frame + 2 <= frame_count; frame += 2) {
+                __m128 input = _mm_loadu_ps(p_input + frame * 2);
+                if constexpr (APPLY_GAIN) {
+                    input = _mm_mul_ps(input, gain);
+                }
+
+                _mm_storeu_ps(p_output + frame * 4, _mm_movelh_ps(zero, input));
+                _mm_storeu_ps(p_output + frame * 4 + 4, _mm_movehl_ps(input, zero));
+            }
+#elif defined(HD_HAPTICS_SIMD_NEON)
+            const float32x4_t gain = {gains[0], gains[1], gains[0], gains[1]};
+            const float32x2_t zero = vdup_n_f32(0.0f);
+
+            // 2 frames per iteration
+            for (; frame + 2 <= frame_count; frame += 2) {
+                float32x4_t input = vld1q_f32(p_input + frame * 2);
+                if constexpr (APPLY_GAIN) {
+                    input = vmulq_f32(input, gain);
+                }
+
+                vst1q_f32(p_output + frame * 4, vcombine_f32(zero, vget_low_f32(input)));
+                vst1q_f32(p_output + frame * 4 + 4, vcombine_f32(zero, vget_high_f32(input)));
+            }
+#endif
+
+            return frame;
+        }
+    };
+} // namespace hd_haptics
@@ -0,0 +1,154 @@
+#include "DriftCompensator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hd_haptics {
+    // Time constant of the fill level average. Godot delivers audio in blocks, so the raw fill level is
+    // a sawtooth that must be smoothed before it can drive the playback rate.
+    constexpr double FILL_AVERAGE_TIME_CONSTANT = 0.5;
+
+    // Maximum playback rate deviation used for regular drift compensation (0.5%). Real clock drift is
+    // far below this, so the correction stays inaudible and unnoticeable on the actuators.
+    constexpr double MAX_DRIFT_CORRECTION = 0.005;
+    constexpr double PROPORTIONAL_GAIN = 0.002;
+    constexpr double INTEGRAL_GAIN = 0.0002;
+    constexpr double INTEGRAL_LIMIT = MAX_DRIFT_CORRECTION / INTEGRAL_GAIN;
+
+    // Playback rate limits when the time stretch overflow policy is catching up on a backlog.
+    constexpr double CATCH_UP_GAIN = 0.25;
+    constexpr double MAX_CATCH_UP = 0.25;
+
+    void DriftCompensator::reset(ma_uint32 target_frames, ma_uint32 input_rate, ma_uint32 output_rate, bool time_stretch, PolyphaseResampler::Quality quality) {
+        m_target_frames = std::max<ma_uint32>(target_frames, 1);
+        m_output_rate = std::max<ma_uint32>(output_rate, 1);
+        m_rate_ratio = static_cast<double>(input_rate) / m_output_rate;
+        m_time_stretch = time_stretch;
+
+        m_primed = false;
+        m_catching_up = false;
+        m_fill_average = 0.0;
+        m_integral = 0.0;
+        m_ratio = 1.0;
+        m_fill_level = 0;
+        m_events = {};
+        m_phase = 1.0;
+        m_resampler.initialize(quality, input_rate, m_output_rate);
+    }
+
+    ma_uint32 DriftCompensator::process(BroadcastRingBuffer::Reader& reader, float* p_output, ma_uint32 frame_count) {
+        const uint64_t dropped_frames = m_events.dropped_frames;
+        ma_uint32 fill_level = reader.available(m_events.dropped_frames);
+        m_fill_level = fill_level;
+
+        if (!m_primed) {
+            // After startup or an underrun, wait until the target latency is buffered again
+            if (fill_level < m_target_frames) {
+                return 0;
+            }
+
+            // The integral term is kept, it still holds the learned clock drift
+            m_primed = true;
+            m_fill_average = fill_level;
+        }
+
+        handle_overflow(reader, fill_level);
+        update_ratio(fill_level, frame_count);
+
+        const double step = m_ratio * m_rate_ratio;
+
+        const float* p_mapped_buffer = nullptr;
+        ma_uint32 mapped_frames = 0;
+        ma_uint32 mapped_position = 0;
+
+        auto read_frame = [&](ma_uint32 frames_remaining) {
+            if (mapped_position == mapped_frames) {
+                reader.skip(mapped_frames);
+
+                mapped_frames = std::min(static_cast<ma_uint32>(std::ceil(frames_remaining * step)) + 1, reader.available(m_events.dropped_frames));
+                mapped_position = 0;
+
+                if (mapped_frames == 0) {
+                    return false;
+                }
+
+                p_mapped_buffer = reader.map(mapped_frames);
+            }
+
+            m_resampler.push(p_mapped_buffer + static_cast<size_t>(mapped_position) * CHANNELS);
+            ++mapped_position;
+
+            return true;
+        };
+
+        ma_uint32 frames_produced = 0;
+
+        while (frames_produced < frame_count) {
+            bool underrun = false;
+
+            while (m_phase >= 1.0) {
+                if (!read_frame(frame_count - frames_produced)) {
+                    underrun = true;
+                    break;
+                }
+
+                m_phase -= 1.0;
+            }
+
+            if (underrun) {
+                m_primed = false;
+                ++m_events.underruns;
+                break;
+            }
+
+            m_resampler.interpolate(static_cast<float>(m_phase), p_output + static_cast<size_t>(frames_produced) * CHANNELS);
+
+            m_phase += step;
+            ++frames_produced;
+        }
+
+        reader.skip(mapped_position);
+
+        if (m_events.dropped_frames != dropped_frames) {
+            ++m_events.overruns;
+        }
+
+        return frames_produced;
+    }
+
+    void DriftCompensator::handle_overflow(BroadcastRingBuffer::Reader& reader, ma_uint32& fill_level) {
+        const ma_uint32 high_water_mark = m_target_frames * 2;
+
+        if (m_time_stretch) {
+            // Play the backlog faster until we are back at the target instead of skipping audio
+            if (fill_level > high_water_mark) {
+                m_catching_up = true;
+            } else if (fill_level <= m_target_frames) {
+                m_catching_up = false;
+            }
+        } else if (fill_level > high_water_mark) {
+            const ma_uint32 excess_frames = fill_level - m_target_frames;
+            reader.skip(excess_frames);
+            m_events.dropped_frames += excess_frames;
+
+            fill_level -= excess_frames;
+            m_fill_average = fill_level;
+        }
+    }
+
+    void DriftCompensator::update_ratio(ma_uint32 fill_level, ma_uint32 frame_count) {
+        const double seconds = static_cast<double>(frame_count) / m_output_rate;
+        const double alpha = std::min(1.0, seconds / FILL_AVERAGE_TIME_CONSTANT);
+        m_fill_average += (fill_level - m_fill_average) * alpha;
+
+        const double error = (m_fill_average - m_target_frames) / m_target_frames;
+
+        if (m_catching_up) {
+            m_ratio = 1.0 + std::clamp(error * CATCH_UP_GAIN, 0.0, MAX_CATCH_UP);
+            return;
+        }
+
+        m_integral = std::clamp(m_integral + error * seconds, -INTEGRAL_LIMIT, INTEGRAL_LIMIT);
+        m_ratio = 1.0 + std::clamp(error * PROPORTIONAL_GAIN + m_integral * INTEGRAL_GAIN, -MAX_DRIFT_CORRECTION, MAX_DRIFT_CORRECTION);
+    }
+} // namespace hd_haptics
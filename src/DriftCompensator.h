@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+
+#include "BroadcastRingBuffer.h"
+#include "PolyphaseResampler.h"
+#include "external/miniaudio_init.h"
+
+namespace hd_haptics {
+    /// Reads stereo frames out of the ring buffer at a slightly adjusted rate so that the fill level
+    /// stays close to the target latency. This compensates for the drift between the Godot mix clock
+    /// and the device clock, which would otherwise make the buffer grow or run dry over time.
+    ///
+    /// The same pass converts from the stream rate to the device rate, so the drift correction and the
+    /// rate conversion cost a single interpolation.
+    class DriftCompensator {
+    public:
+        static constexpr int CHANNELS = 2;
+
+        struct Events {
+            /// Frames skipped by the overflow policy or lost to the producer.
+            uint64_t dropped_frames = 0;
+            uint32_t underruns = 0;
+            uint32_t overruns = 0;
+        };
+
+        /// Prepares the compensator for a freshly attached reader. `target_frames` is at the `input_rate` of the
+        /// stream, process() produces frames at `output_rate`. Allocates the resampler tables.
+        void reset(ma_uint32 target_frames, ma_uint32 input_rate, ma_uint32 output_rate, bool time_stretch, PolyphaseResampler::Quality quality);
+
+        /// Produces up to `frame_count` interleaved stereo frames into `p_output`. Returns the number
+        /// of frames produced; the remainder must be filled with silence by the caller.
+        ma_uint32 process(BroadcastRingBuffer::Reader& reader, float* p_output, ma_uint32 frame_count);
+
+        /// Playback rate correction for the drift, excluding the rate conversion.
+        [[nodiscard]] double get_ratio() const {
+            return m_ratio;
+        }
+
+        /// Input frames already read from the ring buffer but not played yet.
+        [[nodiscard]] ma_uint32 get_resampler_latency_frames() const {
+            return m_resampler.get_latency_frames();
+        }
+
+        /// Fill level of the ring buffer seen by the last process() call.
+        [[nodiscard]] ma_uint32 get_fill_level() const {
+            return m_fill_level;
+        }
+
+        /// Returns what happened since the last call.
+        Events take_events() {
+            const Events events = m_events;
+            m_events = {};
+            return events;
+        }
+
+    private:
+        void handle_overflow(BroadcastRingBuffer::Reader& reader, ma_uint32& fill_level);
+        void update_ratio(ma_uint32 fill_level, ma_uint32 frame_count);
+
+        ma_uint32 m_target_frames = 0;
+        ma_uint32 m_output_rate = 0;
+        // Input frames per output frame without drift
+        double m_rate_ratio = 1.0;
+        bool m_time_stretch = false;
+
+        bool m_primed = false;
+        bool m_catching_up = false;
+        double m_fill_average = 0.0;
+        double m_integral = 0.0;
+        double m_ratio = 1.0;
+        ma_uint32 m_fill_level = 0;
+        Events m_events;
+
+        // Fractional read position between the two center frames of the resampler history
+        double m_phase = 0.0;
+        PolyphaseResampler m_resampler;
+    };
+} // namespace hd_haptics
@@ -0,0 +1,67 @@
+#include "HapticsCalibrationStore.h"
+
+#include <cctype>
+#include <godot_cpp/classes/config_file.hpp>
+#include <godot_cpp/core/class_db.hpp>
+
+namespace hd_haptics {
+    constexpr const char* CALIBRATION_FILE_PATH = "user://controller_haptics.cfg";
+    constexpr const char* CALIBRATION_SECTION = "period_calibration";
+
+    std::string HapticsCalibrationStore::get_device_key(const ma_context& context, const ma_device_id& device_id, ma_share_mode share_mode) {
+        std::string id;
+
+        // The sink name and the endpoint id both survive reconnects and reboots
+        switch (context.backend) {
+            case ma_backend_pulseaudio:
+                id = device_id.pulse;
+                break;
+            case ma_backend_wasapi:
+                for (const ma_wchar_win32 character : device_id.wasapi) {
+                    if (character == 0) {
+                        break;
+                    }
+                    id.push_back(character < 0x80 ? static_cast<char>(character) : '_');
+                }
+                break;
+            default:
+                id = "unknown";
+                break;
+        }
+
+        std::string key = std::string(ma_get_backend_name(context.backend)) + "_" + id + (share_mode == ma_share_mode_exclusive ? "_exclusive" : "_shared");
+
+        // Config file keys are limited to identifier characters
+        for (char& character : key) {
+            if (std::isalnum(static_cast<unsigned char>(character)) == 0) {
+                character = '_';
+            }
+        }
+
+        return key;
+    }
+
+    std::optional<uint32_t> HapticsCalibrationStore::load_period_ms(const std::string& device_key) {
+        godot::Ref<godot::ConfigFile> file;
+        file.instantiate();
+
+        if (file->load(CALIBRATION_FILE_PATH) != godot::OK || !file->has_section_key(CALIBRATION_SECTION, device_key.c_str())) {
+            return std::nullopt;
+        }
+
+        return static_cast<uint32_t>(static_cast<int64_t>(file->get_value(CALIBRATION_SECTION, device_key.c_str())));
+    }
+
+    void HapticsCalibrationStore::save_period_ms(const std::string& device_key, uint32_t period_ms) {
+        godot::Ref<godot::ConfigFile> file;
+        file.instantiate();
+
+        // Keep the other devices, a missing file just starts out empty
+        file->load(CALIBRATION_FILE_PATH);
+        file->set_value(CALIBRATION_SECTION, device_key.c_str(), static_cast<int64_t>(period_ms));
+
+        if (file->save(CALIBRATION_FILE_PATH) != godot::OK) {
+            WARN_PRINT("Failed to save the haptics device calibration.");
+        }
+    }
+} // namespace hd_haptics
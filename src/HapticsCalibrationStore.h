@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "external/miniaudio_init.h"
+
+namespace hd_haptics {
+    /// Remembers the calibrated period of every device across launches, in a config file in the user data folder.
+    class HapticsCalibrationStore {
+    public:
+        /// Identifies a device and the share mode it was calibrated in. Stable across launches and reconnects.
+        static std::string get_device_key(const ma_context& context, const ma_device_id& device_id, ma_share_mode share_mode);
+
+        /// The stored period in milliseconds. Zero means the backend default was the only stable configuration.
+        static std::optional<uint32_t> load_period_ms(const std::string& device_key);
+        static void save_period_ms(const std::string& device_key, uint32_t period_ms);
+    };
+} // namespace hd_haptics
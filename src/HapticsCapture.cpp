@@ -0,0 +1,137 @@
+#include "HapticsCapture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+
+namespace hd_haptics {
+    // The taps hold about a second of audio, the recorder empties them far more often than that
+    constexpr auto WRITE_INTERVAL = std::chrono::milliseconds(20);
+
+    HapticsCaptureTap::HapticsCaptureTap(int controller_index, uint32_t sample_rate) :
+        m_controller_index(controller_index), m_sample_rate(sample_rate), m_slots(SLOTS) {}
+
+    void HapticsCaptureTap::push(const float* p_frames, uint32_t frame_count, uint64_t timestamp_ns, uint64_t frame_position) {
+        const uint64_t write_index = m_write_index.load(std::memory_order_relaxed);
+
+        if (write_index - m_read_index.load(std::memory_order_acquire) >= SLOTS) {
+            m_dropped_chunks.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        Slot& slot = m_slots[write_index % SLOTS];
+        slot.timestamp_ns = timestamp_ns;
+        slot.frame_position = frame_position;
+        slot.frame_count = std::min(frame_count, SLOT_FRAMES);
+        std::memcpy(slot.frames.data(), p_frames, static_cast<size_t>(slot.frame_count) * capture_format::CHANNELS * sizeof(float));
+
+        m_write_index.store(write_index + 1, std::memory_order_release);
+    }
+
+    HapticsRecorder::~HapticsRecorder() {
+        stop();
+    }
+
+    bool HapticsRecorder::start(const std::filesystem::path& path) {
+        stop();
+
+        if (!m_file.open(path)) {
+            return false;
+        }
+
+        m_start_time = std::chrono::steady_clock::now();
+
+        capture_format::FileHeader header;
+        header.start_time_us =
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        std::memcpy(m_file.append(sizeof(header)), &header, sizeof(header));
+
+        m_has_failed.store(false);
+        m_is_recording.store(true);
+        m_thread = std::jthread([this](const std::stop_token& stop_token) { run(stop_token); });
+
+        return true;
+    }
+
+    void HapticsRecorder::stop() {
+        if (m_thread.joinable()) {
+            m_thread.request_stop();
+            m_thread.join();
+        }
+
+        if (m_file.is_open()) {
+            write_pending_chunks();
+            m_file.close();
+        }
+
+        std::lock_guard lock(m_taps_mutex);
+        m_taps.clear();
+        m_is_recording.store(false);
+    }
+
+    std::shared_ptr<HapticsCaptureTap> HapticsRecorder::create_tap(int controller_index, uint32_t sample_rate) {
+        auto tap = std::make_shared<HapticsCaptureTap>(controller_index, sample_rate);
+
+        std::lock_guard lock(m_taps_mutex);
+        m_taps.push_back(tap);
+
+        return tap;
+    }
+
+    uint64_t HapticsRecorder::get_dropped_chunks() {
+        uint64_t dropped_chunks = 0;
+
+        std::lock_guard lock(m_taps_mutex);
+        for (const auto& tap : m_taps) {
+            dropped_chunks += tap->get_dropped_chunks();
+        }
+
+        return dropped_chunks;
+    }
+
+    void HapticsRecorder::run(const std::stop_token& stop_token) {
+        std::mutex mutex;
+        std::condition_variable_any wake_up;
+
+        while (!stop_token.stop_requested()) {
+            // Only a stop request wakes the recorder before the interval passed
+            {
+                std::unique_lock lock(mutex);
+                wake_up.wait_for(lock, stop_token, WRITE_INTERVAL, [] { return false; });
+            }
+
+            write_pending_chunks();
+        }
+    }
+
+    void HapticsRecorder::write_pending_chunks() {
+        const auto start_time_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(m_start_time.time_since_epoch()).count());
+
+        std::lock_guard lock(m_taps_mutex);
+
+        for (const auto& tap : m_taps) {
+            tap->drain([&](const HapticsCaptureTap::Slot& slot) {
+                const size_t frame_bytes = static_cast<size_t>(slot.frame_count) * capture_format::CHANNELS * sizeof(float);
+
+                // The file closes itself when it can't grow, the slots are still freed so the taps don't fill up
+                uint8_t* p_chunk = m_file.append(sizeof(capture_format::ChunkHeader) + frame_bytes);
+                if (p_chunk == nullptr) {
+                    m_has_failed.store(true);
+                    return;
+                }
+
+                capture_format::ChunkHeader header;
+                header.controller_index = tap->get_controller_index();
+                header.sample_rate = tap->get_sample_rate();
+                header.frame_count = slot.frame_count;
+                header.timestamp_ns = slot.timestamp_ns > start_time_ns ? slot.timestamp_ns - start_time_ns : 0;
+                header.frame_position = slot.frame_position;
+
+                // Straight into the mapped pages, the OS writes them back in the background
+                std::memcpy(p_chunk, &header, sizeof(header));
+                std::memcpy(p_chunk + sizeof(header), slot.frames.data(), frame_bytes);
+            });
+        }
+    }
+} // namespace hd_haptics
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include "MappedFile.h"
+
+namespace hd_haptics {
+    /// Layout of capture files: a CaptureFileHeader followed by any number of chunks, each a CaptureChunkHeader
+    /// and `frame_count` interleaved stereo float frames as rendered for one controller. Chunks of different
+    /// controllers are interleaved in the order they were written.
+    namespace capture_format {
+        constexpr std::array<char, 8> FILE_MAGIC = {'H', 'D', 'H', 'C', 'A', 'P', 'T', 0};
+        constexpr uint32_t VERSION = 1;
+        constexpr uint32_t CHUNK_MAGIC = 0x4b4e4843; // "CHNK"
+        constexpr uint32_t CHANNELS = 2;
+
+        struct FileHeader {
+            std::array<char, 8> magic = FILE_MAGIC;
+            uint32_t version = VERSION;
+            uint32_t channels = CHANNELS;
+            /// Wall clock time the capture started at, in microseconds since the Unix epoch.
+            int64_t start_time_us = 0;
+            uint64_t reserved = 0;
+        };
+
+        struct ChunkHeader {
+            uint32_t magic = CHUNK_MAGIC;
+            int32_t controller_index = -1;
+            uint32_t sample_rate = 0;
+            uint32_t frame_count = 0;
+            /// Time the first frame was rendered at, in nanoseconds since the capture started.
+            uint64_t timestamp_ns = 0;
+            /// Frames rendered by the device before this chunk. A gap to the previous chunk of the controller means
+            /// frames were lost because the capture fell behind.
+            uint64_t frame_position = 0;
+        };
+
+        static_assert(sizeof(FileHeader) == 32 && sizeof(ChunkHeader) == 32, "Capture headers must not contain padding");
+    } // namespace capture_format
+
+    /// Hands the frames rendered for one controller from its audio thread to the HapticsRecorder. The slots are
+    /// allocated up front, so pushing is a copy into a single-producer single-consumer queue.
+    class HapticsCaptureTap {
+    public:
+        static constexpr uint32_t SLOT_FRAMES = 256;
+        static constexpr uint32_t SLOTS = 256;
+
+        struct Slot {
+            uint64_t timestamp_ns = 0;
+            uint64_t frame_position = 0;
+            uint32_t frame_count = 0;
+            std::array<float, SLOT_FRAMES * capture_format::CHANNELS> frames{};
+        };
+
+        HapticsCaptureTap(int controller_index, uint32_t sample_rate);
+
+        /// Called from the audio thread. Frames that don't fit because the recorder fell behind are dropped.
+        void push(const float* p_frames, uint32_t frame_count, uint64_t timestamp_ns, uint64_t frame_position);
+
+        /// Called from the recorder thread. Passes every pushed slot to `consume` and frees it.
+        template <typename Consumer>
+        void drain(Consumer&& consume) {
+            const uint64_t write_index = m_write_index.load(std::memory_order_acquire);
+            uint64_t read_index = m_read_index.load(std::memory_order_relaxed);
+
+            for (; read_index < write_index; ++read_index) {
+                consume(m_slots[read_index % SLOTS]);
+            }
+
+            m_read_index.store(read_index, std::memory_order_release);
+        }
+
+        [[nodiscard]] int get_controller_index() const {
+            return m_controller_index;
+        }
+
+        [[nodiscard]] uint32_t get_sample_rate() const {
+            return m_sample_rate;
+        }
+
+        [[nodiscard]] uint64_t get_dropped_chunks() const {
+            return m_dropped_chunks.load(std::memory_order_relaxed);
+        }
+
+    private:
+        const int m_controller_index;
+        const uint32_t m_sample_rate;
+
+        std::vector<Slot> m_slots;
+        alignas(64) std::atomic<uint64_t> m_write_index = 0;
+        alignas(64) std::atomic<uint64_t> m_read_index = 0;
+        std::atomic<uint64_t> m_dropped_chunks = 0;
+    };
+
+    /// Writes what the devices render to a capture file. Each device gets a tap, and a background thread moves
+    /// the pushed chunks into the memory mapped file, so the audio threads never touch the file. Frames are
+    /// copied twice, into a tap slot and from there into the mapped pages, but never buffered or written again.
+    class HapticsRecorder {
+    public:
+        HapticsRecorder() = default;
+        ~HapticsRecorder();
+
+        HapticsRecorder(const HapticsRecorder&) = delete;
+        HapticsRecorder& operator=(const HapticsRecorder&) = delete;
+
+        bool start(const std::filesystem::path& path);
+
+        /// Writes what the taps still hold and closes the file. Taps must no longer be pushed to.
+        void stop();
+
+        /// Whether a recording was started and not stopped yet, even if writing it failed meanwhile.
+        [[nodiscard]] bool is_recording() const {
+            return m_is_recording.load();
+        }
+
+        /// Whether the file couldn't grow anymore. The recording ends there, the taps are still drained.
+        [[nodiscard]] bool has_failed() const {
+            return m_has_failed.load();
+        }
+
+        /// Creates the tap for a device. Only valid while recording.
+        std::shared_ptr<HapticsCaptureTap> create_tap(int controller_index, uint32_t sample_rate);
+
+        /// Chunks the taps had to drop since the recording started.
+        [[nodiscard]] uint64_t get_dropped_chunks();
+
+    private:
+        void run(const std::stop_token& stop_token);
+        void write_pending_chunks();
+
+        // Only touched by the recorder thread while it runs
+        MappedFileWriter m_file;
+        std::chrono::steady_clock::time_point m_start_time;
+        std::atomic<bool> m_is_recording = false;
+        std::atomic<bool> m_has_failed = false;
+
+        // Guards the taps, which the recorder thread drains while devices come and go
+        std::mutex m_taps_mutex;
+        std::vector<std::shared_ptr<HapticsCaptureTap>> m_taps;
+
+        std::jthread m_thread;
+    };
+} // namespace hd_haptics
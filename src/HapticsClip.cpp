@@ -0,0 +1,58 @@
+#include "HapticsClip.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace hd_haptics {
+    std::unique_ptr<HapticsClip> HapticsClip::decode_pcm(
+        const uint8_t* p_data, size_t size, int bits_per_sample, int channels, uint32_t source_sample_rate, uint32_t sample_rate
+    ) {
+        if ((bits_per_sample != 8 && bits_per_sample != 16) || channels < 1 || channels > CHANNELS || source_sample_rate == 0 || sample_rate == 0) {
+            return nullptr;
+        }
+
+        const size_t bytes_per_frame = static_cast<size_t>(bits_per_sample / 8) * channels;
+        const size_t source_frame_count = size / bytes_per_frame;
+
+        // Convert to stereo float at the source rate first
+        std::vector<float> source(source_frame_count * CHANNELS);
+
+        for (size_t frame = 0; frame < source_frame_count; ++frame) {
+            for (int channel = 0; channel < CHANNELS; ++channel) {
+                const size_t sample = frame * channels + std::min(channel, channels - 1);
+
+                if (bits_per_sample == 8) {
+                    source[frame * CHANNELS + channel] = static_cast<float>(static_cast<int8_t>(p_data[sample])) / 128.0f;
+                } else {
+                    int16_t value;
+                    std::memcpy(&value, p_data + sample * 2, sizeof(value));
+                    source[frame * CHANNELS + channel] = static_cast<float>(value) / 32768.0f;
+                }
+            }
+        }
+
+        // Linearly resample to the stream rate. Haptic content is far below the Nyquist frequency of either rate.
+        const double step = static_cast<double>(source_sample_rate) / sample_rate;
+        const auto frame_count = static_cast<uint32_t>(static_cast<double>(source_frame_count) / step);
+
+        auto clip = std::make_unique<HapticsClip>();
+        clip->m_frame_count = frame_count;
+        clip->m_frames.reset(static_cast<float*>(::operator new[](std::max<size_t>(frame_count, 1) * CHANNELS * sizeof(float), ALIGNMENT)));
+
+        for (uint32_t frame = 0; frame < frame_count; ++frame) {
+            const double position = frame * step;
+            const auto index = static_cast<size_t>(position);
+            const size_t next_index = std::min(index + 1, source_frame_count - 1);
+            const auto t = static_cast<float>(position - static_cast<double>(index));
+
+            for (int channel = 0; channel < CHANNELS; ++channel) {
+                const float a = source[index * CHANNELS + channel];
+                const float b = source[next_index * CHANNELS + channel];
+                clip->m_frames[static_cast<size_t>(frame) * CHANNELS + channel] = a + (b - a) * t;
+            }
+        }
+
+        return clip;
+    }
+} // namespace hd_haptics
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+namespace hd_haptics {
+    /// A haptic clip decoded ahead of time to interleaved stereo float frames at the stream sample rate, so
+    /// playing it in the device callback is a plain multiply-add without any decoding or allocation.
+    class HapticsClip {
+    public:
+        static constexpr int CHANNELS = 2;
+
+        /// Decodes signed 8 or 16 bit PCM and resamples it to `sample_rate`.
+        static std::unique_ptr<HapticsClip> decode_pcm(
+            const uint8_t* p_data, size_t size, int bits_per_sample, int channels, uint32_t source_sample_rate, uint32_t sample_rate
+        );
+
+        [[nodiscard]] const float* get_frames() const {
+            return m_frames.get();
+        }
+
+        [[nodiscard]] uint32_t get_frame_count() const {
+            return m_frame_count;
+        }
+
+    private:
+        // Frames start on a cache line, so the mixing loops never straddle one at the start of a clip
+        static constexpr std::align_val_t ALIGNMENT{64};
+
+        struct AlignedDeleter {
+            void operator()(float* p_frames) const {
+                ::operator delete[](p_frames, ALIGNMENT);
+            }
+        };
+
+        std::unique_ptr<float[], AlignedDeleter> m_frames;
+        uint32_t m_frame_count = 0;
+    };
+} // namespace hd_haptics
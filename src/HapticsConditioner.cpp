@@ -0,0 +1,318 @@
+#include "HapticsConditioner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#include "Simd.h"
+
+namespace hd_haptics {
+    constexpr float DC_BLOCKER_CUTOFF_HZ = 10.0f;
+    constexpr float MINIMUM_LEVEL = 1e-6f;
+
+    // Both channels of a frame as one vector. Two lanes fill half an SSE register, AVX has nothing to add.
+#if defined(HD_HAPTICS_SIMD_AVX) || defined(HD_HAPTICS_SIMD_SSE2)
+    using FrameVector = __m128;
+
+    // __m64 may alias floats, unlike the double behind _mm_load_sd()
+    static FrameVector load_frame(const float* p_frame) {
+        return _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(p_frame));
+    }
+
+    static void store_frame(float* p_frame, FrameVector frame) {
+        _mm_storel_pi(reinterpret_cast<__m64*>(p_frame), frame);
+    }
+
+    static FrameVector splat(float value) {
+        return _mm_set1_ps(value);
+    }
+
+    static FrameVector add(FrameVector a, FrameVector b) {
+        return _mm_add_ps(a, b);
+    }
+
+    static FrameVector subtract(FrameVector a, FrameVector b) {
+        return _mm_sub_ps(a, b);
+    }
+
+    static FrameVector multiply(FrameVector a, FrameVector b) {
+        return _mm_mul_ps(a, b);
+    }
+
+    static FrameVector max(FrameVector a, FrameVector b) {
+        return _mm_max_ps(a, b);
+    }
+
+    static FrameVector abs(FrameVector frame) {
+        return _mm_and_ps(frame, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)));
+    }
+#elif defined(HD_HAPTICS_SIMD_NEON)
+    using FrameVector = float32x2_t;
+
+    static FrameVector load_frame(const float* p_frame) {
+        return vld1_f32(p_frame);
+    }
+
+    static void store_frame(float* p_frame, FrameVector frame) {
+        vst1_f32(p_frame, frame);
+    }
+
+    static FrameVector splat(float value) {
+        return vdup_n_f32(value);
+    }
+
+    static FrameVector add(FrameVector a, FrameVector b) {
+        return vadd_f32(a, b);
+    }
+
+    static FrameVector subtract(FrameVector a, FrameVector b) {
+        return vsub_f32(a, b);
+    }
+
+    static FrameVector multiply(FrameVector a, FrameVector b) {
+        return vmul_f32(a, b);
+    }
+
+    static FrameVector max(FrameVector a, FrameVector b) {
+        return vmax_f32(a, b);
+    }
+
+    static FrameVector abs(FrameVector frame) {
+        return vabs_f32(frame);
+    }
+#else
+    using FrameVector = std::array<float, HapticsConditioner::CHANNELS>;
+
+    static FrameVector load_frame(const float* p_frame) {
+        return {p_frame[0], p_frame[1]};
+    }
+
+    static void store_frame(float* p_frame, FrameVector frame) {
+        p_frame[0] = frame[0];
+        p_frame[1] = frame[1];
+    }
+
+    static FrameVector splat(float value) {
+        return {value, value};
+    }
+
+    static FrameVector add(FrameVector a, FrameVector b) {
+        return {a[0] + b[0], a[1] + b[1]};
+    }
+
+    static FrameVector subtract(FrameVector a, FrameVector b) {
+        return {a[0] - b[0], a[1] - b[1]};
+    }
+
+    static FrameVector multiply(FrameVector a, FrameVector b) {
+        return {a[0] * b[0], a[1] * b[1]};
+    }
+
+    static FrameVector max(FrameVector a, FrameVector b) {
+        return {std::max(a[0], b[0]), std::max(a[1], b[1])};
+    }
+
+    static FrameVector abs(FrameVector frame) {
+        return {std::abs(frame[0]), std::abs(frame[1])};
+    }
+#endif
+
+    static float linear_to_db(float linear) {
+        return 20.0f * std::log10(std::max(linear, MINIMUM_LEVEL));
+    }
+
+    static float db_to_linear(float db) {
+        return std::pow(10.0f, db / 20.0f);
+    }
+
+    // Recursive filters decay into denormals once the input goes silent, which is very slow on most CPUs.
+    // Flushing the state once per block is enough to avoid that.
+    static void flush_denormals(std::array<float, HapticsConditioner::CHANNELS>& state) {
+        for (float& value : state) {
+            value = std::abs(value) < MINIMUM_LEVEL * MINIMUM_LEVEL ? 0.0f : value;
+        }
+    }
+
+    void HapticsConditioner::set_sample_rate(uint32_t sample_rate) {
+        m_sample_rate = sample_rate;
+        update_coefficients();
+        reset_state();
+    }
+
+    void HapticsConditioner::set_settings(const Settings& settings) {
+        if (settings == m_settings) {
+            return;
+        }
+
+        const bool was_enabled = is_enabled();
+        m_settings = settings;
+        update_coefficients();
+
+        // Don't let stale filter state or delayed frames from an earlier use leak out when re-enabled
+        if (!was_enabled) {
+            reset_state();
+        }
+    }
+
+    void HapticsConditioner::update_coefficients() {
+        const auto sample_rate = static_cast<float>(m_sample_rate);
+
+        m_dc_coefficient = 1.0f - 2.0f * std::numbers::pi_v<float> * DC_BLOCKER_CUTOFF_HZ / sample_rate;
+
+        // RBJ audio EQ cookbook biquads
+        const float cutoff = std::clamp(m_settings.filter_cutoff_hz, 1.0f, sample_rate * 0.45f);
+        const float omega = 2.0f * std::numbers::pi_v<float> * cutoff / sample_rate;
+        const float alpha = std::sin(omega) / (2.0f * std::max(m_settings.filter_resonance, 0.01f));
+        const float cos_omega = std::cos(omega);
+        const float a0 = 1.0f + alpha;
+
+        if (m_settings.filter_mode == FilterMode::BandPass) {
+            m_b0 = alpha / a0;
+            m_b1 = 0.0f;
+            m_b2 = -alpha / a0;
+        } else {
+            m_b0 = (1.0f - cos_omega) / 2.0f / a0;
+            m_b1 = (1.0f - cos_omega) / a0;
+            m_b2 = m_b0;
+        }
+        m_a1 = -2.0f * cos_omega / a0;
+        m_a2 = (1.0f - alpha) / a0;
+
+        const float block_seconds = static_cast<float>(GAIN_BLOCK_FRAMES) / sample_rate;
+        m_attack_coefficient = 1.0f - std::exp(-block_seconds / std::max(m_settings.compressor_attack_ms / 1000.0f, block_seconds));
+        m_release_coefficient = 1.0f - std::exp(-block_seconds / std::max(m_settings.compressor_release_ms / 1000.0f, block_seconds));
+    }
+
+    void HapticsConditioner::reset_state() {
+        m_dc_input = {};
+        m_dc_output = {};
+        m_z1 = {};
+        m_z2 = {};
+        m_envelope = 0.0f;
+        m_block_peak = 0.0f;
+        m_previous_limit_db = 0.0f;
+        m_gain_from = 1.0f;
+        m_gain_to = 1.0f;
+        m_block_position = 0;
+        m_delay_position = 0;
+        m_delay.fill(0.0f);
+    }
+
+    void HapticsConditioner::process(float* p_frames, uint32_t frame_count) {
+        if (m_settings.dc_blocker) {
+            process_dc_blocker(p_frames, frame_count);
+        }
+
+        if (m_settings.filter_mode != FilterMode::Disabled) {
+            process_filter(p_frames, frame_count);
+        }
+
+        if (m_settings.compressor) {
+            process_compressor(p_frames, frame_count);
+        }
+    }
+
+    void HapticsConditioner::process_dc_blocker(float* p_frames, uint32_t frame_count) {
+        FrameVector input = load_frame(m_dc_input.data());
+        FrameVector output = load_frame(m_dc_output.data());
+        const FrameVector coefficient = splat(m_dc_coefficient);
+
+        for (uint32_t frame = 0; frame < frame_count; ++frame) {
+            float* p_frame = p_frames + frame * CHANNELS;
+
+            const FrameVector sample = load_frame(p_frame);
+            output = add(subtract(sample, input), multiply(coefficient, output));
+            input = sample;
+            store_frame(p_frame, output);
+        }
+
+        store_frame(m_dc_input.data(), input);
+        store_frame(m_dc_output.data(), output);
+        flush_denormals(m_dc_output);
+    }
+
+    void HapticsConditioner::process_filter(float* p_frames, uint32_t frame_count) {
+        // Transposed direct form II. The recursion runs along time, so the two channels are what runs in parallel.
+        FrameVector z1 = load_frame(m_z1.data());
+        FrameVector z2 = load_frame(m_z2.data());
+        const FrameVector b0 = splat(m_b0);
+        const FrameVector b1 = splat(m_b1);
+        const FrameVector b2 = splat(m_b2);
+        const FrameVector a1 = splat(m_a1);
+        const FrameVector a2 = splat(m_a2);
+
+        for (uint32_t frame = 0; frame < frame_count; ++frame) {
+            float* p_frame = p_frames + frame * CHANNELS;
+
+            const FrameVector sample = load_frame(p_frame);
+            const FrameVector output = add(multiply(b0, sample), z1);
+            z1 = add(subtract(multiply(b1, sample), multiply(a1, output)), z2);
+            z2 = subtract(multiply(b2, sample), multiply(a2, output));
+            store_frame(p_frame, output);
+        }
+
+        store_frame(m_z1.data(), z1);
+        store_frame(m_z2.data(), z2);
+        flush_denormals(m_z1);
+        flush_denormals(m_z2);
+    }
+
+    void HapticsConditioner::process_compressor(float* p_frames, uint32_t frame_count) {
+        uint32_t offset = 0;
+
+        // Work in segments that end on gain block boundaries, so the per frame loop has no branches
+        while (offset < frame_count) {
+            const uint32_t segment_frames = std::min(frame_count - offset, GAIN_BLOCK_FRAMES - m_block_position);
+            float* p_segment = p_frames + offset * CHANNELS;
+
+            // Locals keep the compiler from assuming the delay line and the state alias the frames
+            float* p_delay = m_delay.data();
+            const uint32_t delay_position = m_delay_position;
+            const float gain_step = (m_gain_to - m_gain_from) / GAIN_BLOCK_FRAMES;
+            const float gain_start = m_gain_from + gain_step * static_cast<float>(m_block_position + 1);
+            FrameVector peaks = splat(m_block_peak);
+
+            for (uint32_t frame = 0; frame < segment_frames; ++frame) {
+                const uint32_t write_index = (delay_position + frame) & DELAY_MASK;
+                const uint32_t read_index = (delay_position + frame - LOOKAHEAD_FRAMES) & DELAY_MASK;
+                const FrameVector gain = splat(gain_start + gain_step * static_cast<float>(frame));
+
+                const FrameVector sample = load_frame(p_segment + frame * CHANNELS);
+                peaks = max(peaks, abs(sample));
+                store_frame(p_delay + write_index * CHANNELS, sample);
+                store_frame(p_segment + frame * CHANNELS, multiply(load_frame(p_delay + read_index * CHANNELS), gain));
+            }
+
+            // The envelope follows the louder channel
+            Pair peak;
+            store_frame(peak.data(), peaks);
+            m_block_peak = std::max(peak[0], peak[1]);
+            m_delay_position = (m_delay_position + segment_frames) & DELAY_MASK;
+            m_block_position += segment_frames;
+            offset += segment_frames;
+
+            if (m_block_position == GAIN_BLOCK_FRAMES) {
+                finish_gain_block();
+            }
+        }
+    }
+
+    void HapticsConditioner::finish_gain_block() {
+        const float coefficient = m_block_peak > m_envelope ? m_attack_coefficient : m_release_coefficient;
+        m_envelope += (m_block_peak - m_envelope) * coefficient;
+
+        const float overshoot_db = std::max(linear_to_db(m_envelope) - m_settings.compressor_threshold_db, 0.0f);
+        const float compressor_db = -overshoot_db * (1.0f - 1.0f / std::max(m_settings.compressor_ratio, 1.0f));
+
+        // The limiter reacts to the block peak instantly. Holding it for one more block keeps both ends of the gain
+        // ramp below the limit while the delayed block is played.
+        const float limit_db = std::min(m_settings.limiter_ceiling_db - linear_to_db(m_block_peak), 0.0f);
+        const float held_limit_db = std::min(limit_db, m_previous_limit_db);
+        m_previous_limit_db = limit_db;
+
+        m_gain_from = m_gain_to;
+        m_gain_to = db_to_linear(std::min(compressor_db, held_limit_db));
+        m_block_peak = 0.0f;
+        m_block_position = 0;
+    }
+} // namespace hd_haptics
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace hd_haptics {
+    /// Optional processing applied to the bus audio before it is sent to the controllers: a DC blocker, a biquad
+    /// low-pass or band-pass limiting the content to what the voice coil actuators can reproduce, and a look-ahead
+    /// compressor with a limiter that keeps transients below the clipping point.
+    ///
+    /// Processing is done in place on interleaved stereo frames. The recursions run along time, so the inner loops
+    /// process one frame per iteration with both channels in a single SIMD vector. They are branch-free, and gains
+    /// and coefficients are only updated once per block.
+    class HapticsConditioner {
+    public:
+        static constexpr int CHANNELS = 2;
+
+        enum class FilterMode {
+            Disabled,
+            LowPass,
+            BandPass,
+        };
+
+        struct Settings {
+            bool dc_blocker = false;
+
+            FilterMode filter_mode = FilterMode::Disabled;
+            float filter_cutoff_hz = 250.0f;
+            float filter_resonance = 0.707f;
+
+            bool compressor = false;
+            float compressor_threshold_db = -12.0f;
+            float compressor_ratio = 4.0f;
+            float compressor_attack_ms = 2.0f;
+            float compressor_release_ms = 80.0f;
+            float limiter_ceiling_db = -1.0f;
+
+            bool operator==(const Settings&) const = default;
+        };
+
+        void set_sample_rate(uint32_t sample_rate);
+
+        /// Applies new settings. Coefficients are only recomputed if something changed.
+        void set_settings(const Settings& settings);
+
+        [[nodiscard]] bool is_enabled() const {
+            return m_settings.dc_blocker || m_settings.filter_mode != FilterMode::Disabled || m_settings.compressor;
+        }
+
+        void process(float* p_frames, uint32_t frame_count);
+
+    private:
+        // Gains are computed once per block of this size and interpolated in between
+        static constexpr uint32_t GAIN_BLOCK_FRAMES = 32;
+        // The compressor delays the signal by two gain blocks, so the gain always reaches its target before a peak
+        static constexpr uint32_t LOOKAHEAD_FRAMES = GAIN_BLOCK_FRAMES * 2;
+        static constexpr uint32_t DELAY_MASK = LOOKAHEAD_FRAMES * 2 - 1;
+
+        void update_coefficients();
+        void reset_state();
+
+        void process_dc_blocker(float* p_frames, uint32_t frame_count);
+        void process_filter(float* p_frames, uint32_t frame_count);
+        void process_compressor(float* p_frames, uint32_t frame_count);
+        void finish_gain_block();
+
+        uint32_t m_sample_rate = 48000;
+        Settings m_settings;
+
+        using Pair = std::array<float, CHANNELS>;
+
+        float m_dc_coefficient = 0.0f;
+        Pair m_dc_input{};
+        Pair m_dc_output{};
+
+        float m_b0 = 1.0f;
+        float m_b1 = 0.0f;
+        float m_b2 = 0.0f;
+        float m_a1 = 0.0f;
+        float m_a2 = 0.0f;
+        Pair m_z1{};
+        Pair m_z2{};
+
+        float m_attack_coefficient = 0.0f;
+        float m_release_coefficient = 0.0f;
+        float m_envelope = 0.0f;
+        float m_block_peak = 0.0f;
+        float m_previous_limit_db = 0.0f;
+        float m_gain_from = 1.0f;
+        float m_gain_to = 1.0f;
+        uint32_t m_block_position = 0;
+        uint32_t m_delay_position = 0;
+        std::array<float, (DELAY_MASK + 1) * CHANNELS> m_delay{};
+    };
+} // namespace hd_haptics
@@ -0,0 +1,207 @@
+#include "HapticsDevice.h"
+
+#include <array>
+#include <condition_variable>
+#include <cstring>
+#include <format>
+#include <mutex>
+#include <godot_cpp/core/class_db.hpp>
+
+#include "HapticsDeviceManager.h"
+
+// The device configuration below needs the backend specific definitions from the implementation
+#define MINIAUDIO_IMPLEMENTATION
+#include "external/miniaudio_init.h"
+
+#define HANDLE_MA_ERROR(ma_result)                                                                                                                             \
+    if (ma_result != MA_SUCCESS) {                                                                                                                             \
+        uninitialize();                                                                                                                                        \
+        if (m_is_probe) {                                                                                                                                      \
+            return false;                                                                                                                                      \
+        }                                                                                                                                                      \
+        ERR_FAIL_V_MSG(false, std::format("miniaudio: {}", ma_result_description(ma_result)).c_str());                                                         \
+    }
+
+namespace hd_haptics {
+    constexpr int OUTPUT_CHANNELS = HapticsRenderer::OUTPUT_CHANNELS;
+
+    // Periods tried by calibrate_period(), from the safest to the smallest
+    constexpr std::array<uint32_t, 5> CALIBRATION_PERIODS_MS = {20, 10, 5, 3, 2};
+    constexpr auto CALIBRATION_PROBE_DURATION = std::chrono::milliseconds(1000);
+    // Backends fill their buffers in bursts right after starting, which says nothing about the steady state
+    constexpr auto CALIBRATION_WARM_UP = std::chrono::milliseconds(200);
+
+    HapticsDevice::~HapticsDevice() {
+        uninitialize();
+    }
+
+    bool HapticsDevice::initialize(const ma_device_id& device_id, int controller_index, const Settings& settings) {
+        ma_result result;
+
+        ma_channel device_output_map[OUTPUT_CHANNELS] = {MA_CHANNEL_FRONT_LEFT, MA_CHANNEL_FRONT_RIGHT, MA_CHANNEL_BACK_LEFT, MA_CHANNEL_BACK_RIGHT};
+
+        ma_device_config device_config = ma_device_config_init(ma_device_type_playback);
+        // Zero opens the device at its native rate. Resampling in the renderer avoids another conversion, and its
+        // latency, in miniaudio or the sound server.
+        device_config.sampleRate = 0;
+        device_config.performanceProfile = settings.performance_profile;
+        device_config.periodSizeInMilliseconds = settings.period_ms;
+        device_config.noPreSilencedOutputBuffer = MA_TRUE;
+        device_config.noClip = MA_TRUE;
+        device_config.noFixedSizedCallback = MA_TRUE;
+        device_config.playback.format = ma_format_f32;
+        device_config.playback.channels = OUTPUT_CHANNELS;
+        device_config.playback.pChannelMap = device_output_map;
+        device_config.playback.shareMode = settings.share_mode;
+        device_config.pUserData = this;
+        device_config.dataCallback = output_data_callback;
+        device_config.notificationCallback = device_notification_callback;
+        device_config.playback.pDeviceID = &device_id;
+
+#if defined(MA_HAS_PULSEAUDIO)
+        device_config.pulse.channelMap = MA_PA_CHANNEL_MAP_ALSA;
+        device_config.pulse.blockingMainLoop = MA_FALSE;
+#endif
+
+        m_device = std::make_optional<ma_device>();
+        result = ma_device_init(HapticsDeviceManager::get_singleton()->get_context(), &device_config, &*m_device);
+        HANDLE_MA_ERROR(result);
+
+        m_renderer.initialize(controller_index, m_device->sampleRate);
+
+        // Frames queued in the device buffer count towards the end-to-end latency
+        m_renderer.set_device_buffer_frames(m_device->playback.internalPeriodSizeInFrames * m_device->playback.internalPeriods);
+
+        result = ma_device_start(&*m_device);
+        HANDLE_MA_ERROR(result);
+
+        return true;
+    }
+
+    std::optional<uint32_t> HapticsDevice::calibrate_period(const ma_device_id& device_id, const Settings& settings, const std::stop_token& stop_token) {
+        uint32_t stable_period_ms = 0;
+
+        // Sleeps through a probe unless stopped
+        std::mutex probe_mutex;
+        std::condition_variable_any probe_stopped;
+
+        for (const uint32_t period_ms : CALIBRATION_PERIODS_MS) {
+            Settings probe_settings = settings;
+            probe_settings.period_ms = period_ms;
+
+            // Without streams the probe renders silence, and no controller index routes anything to it
+            HapticsDevice probe;
+            probe.m_is_probe = true;
+            if (!probe.initialize(device_id, -1, probe_settings)) {
+                break;
+            }
+
+            {
+                std::unique_lock lock(probe_mutex);
+                probe_stopped.wait_for(lock, stop_token, CALIBRATION_PROBE_DURATION, [] { return false; });
+            }
+
+            probe.uninitialize();
+
+            if (stop_token.stop_requested()) {
+                break;
+            }
+
+            // A probe that never got past the warm-up didn't get callbacks at all
+            const int64_t min_lead_ns = probe.m_min_lead_ns.load(std::memory_order_relaxed);
+            if (min_lead_ns == INT64_MAX || min_lead_ns <= 0) {
+                break;
+            }
+
+            stable_period_ms = period_ms;
+        }
+
+        // A probe cut short says nothing about the device
+        if (stop_token.stop_requested()) {
+            return std::nullopt;
+        }
+
+        if (stable_period_ms == 0) {
+            const std::string message =
+                std::format("Calibrating the haptics device period failed, not even {} ms worked. The backend picks the period.", CALIBRATION_PERIODS_MS[0]);
+            WARN_PRINT(message.c_str());
+        }
+
+        return stable_period_ms;
+    }
+
+    void HapticsDevice::uninitialize() {
+        if (m_device.has_value()) {
+            m_closing.store(true);
+            ma_device_uninit(&*m_device);
+            m_device = std::nullopt;
+        }
+    }
+
+    void HapticsDevice::suspend() {
+        if (!m_device.has_value() || m_suspended.exchange(true)) {
+            return;
+        }
+
+        ma_device_stop(&*m_device);
+    }
+
+    void HapticsDevice::resume() {
+        if (!m_device.has_value() || !m_suspended.load()) {
+            return;
+        }
+
+        // The compensator primes itself on the next callback, the ring buffer has been drained before suspending
+        if (const ma_result result = ma_device_start(&*m_device); result != MA_SUCCESS) {
+            WARN_PRINT(std::format("miniaudio: {}", ma_result_description(result)).c_str());
+            return;
+        }
+
+        m_suspended.store(false);
+    }
+
+    bool HapticsDevice::is_device(const ma_device_id& device_id) const {
+        // This memcmp is safe: https://github.com/mackron/miniaudio/issues/866#issuecomment-2207374206
+        return m_device.has_value() &&
+               std::memcmp(&m_device->playback.id, &device_id, sizeof(ma_device_id)) == 0; // NOLINT(*-suspicious-memory-comparison)
+    }
+
+    void HapticsDevice::output_data_callback(ma_device* p_device, void* output, const void* input, ma_uint32 p_frame_count) {
+        const auto device = static_cast<HapticsDevice*>(p_device->pUserData);
+
+        if (device->m_is_probe) {
+            device->record_callback_timing(p_frame_count);
+        }
+
+        device->m_renderer.render(static_cast<float*>(output), p_frame_count);
+    }
+
+    void HapticsDevice::record_callback_timing(ma_uint32 frame_count) {
+        const auto now = std::chrono::steady_clock::now();
+
+        if (m_delivered_frames == 0) {
+            m_first_callback_time = now;
+        } else if (const auto elapsed = now - m_first_callback_time; elapsed > CALIBRATION_WARM_UP) {
+            const auto delivered_ns = static_cast<int64_t>(m_delivered_frames * 1'000'000'000 / m_device->sampleRate);
+            const int64_t lead_ns = delivered_ns - std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+
+            if (lead_ns < m_min_lead_ns.load(std::memory_order_relaxed)) {
+                m_min_lead_ns.store(lead_ns, std::memory_order_relaxed);
+            }
+        }
+
+        m_delivered_frames += frame_count;
+    }
+
+    void HapticsDevice::device_notification_callback(const ma_device_notification* notification) {
+        const auto device = static_cast<HapticsDevice*>(notification->pDevice->pUserData);
+
+        // Tearing down the device from within its own notification would deadlock, let the device manager
+        // tell its subscribers instead.
+        if (notification->type == ma_device_notification_type_stopped && !device->m_closing.load() && !device->m_suspended.load()) {
+            if (auto* manager = HapticsDeviceManager::get_singleton()) {
+                manager->report_device_lost(notification->pDevice->playback.id);
+            }
+        }
+    }
+} // namespace hd_haptics
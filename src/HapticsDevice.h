@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stop_token>
+#include <utility>
+#include <vector>
+
+#include "HapticsRenderer.h"
+#include "HapticsStream.h"
+#include "external/miniaudio_init.h"
+
+namespace hd_haptics {
+    /// One opened haptics device. Its callback lets a HapticsRenderer mix the streams fed to the controller at
+    /// the pace of the device clock.
+    class HapticsDevice {
+    public:
+        struct Settings {
+            ma_share_mode share_mode = ma_share_mode_shared;
+            ma_performance_profile performance_profile = ma_performance_profile_low_latency;
+            /// Zero leaves the period to the backend and the performance profile.
+            uint32_t period_ms = 0;
+
+            bool operator==(const Settings&) const = default;
+        };
+
+        HapticsDevice() = default;
+        ~HapticsDevice();
+
+        HapticsDevice(const HapticsDevice&) = delete;
+        HapticsDevice& operator=(const HapticsDevice&) = delete;
+
+        /// Opens the device at its native sample rate, the renderer converts the streams to it.
+        bool initialize(const ma_device_id& device_id, int controller_index, const Settings& settings);
+
+        /// Opens the device with progressively smaller periods, and returns the smallest period in milliseconds
+        /// whose callbacks always came before the device ran dry, or zero if not even the largest one did.
+        /// Blocks for about a second per period tried, and returns nothing as soon as `stop_token` is stopped.
+        static std::optional<uint32_t> calibrate_period(const ma_device_id& device_id, const Settings& settings, const std::stop_token& stop_token);
+
+        /// See HapticsRenderer::set_streams().
+        void set_streams(const std::vector<std::shared_ptr<HapticsStream>>& streams) {
+            m_renderer.set_streams(streams);
+        }
+
+        /// See HapticsRenderer::set_capture_tap().
+        void set_capture_tap(std::shared_ptr<HapticsCaptureTap> tap) {
+            m_renderer.set_capture_tap(std::move(tap));
+        }
+
+        /// Stops the device without closing it, so resume() can restart it without renegotiating the stream.
+        void suspend();
+        void resume();
+
+        [[nodiscard]] bool is_device(const ma_device_id& device_id) const;
+
+        [[nodiscard]] int get_controller_index() const {
+            return m_renderer.get_controller_index();
+        }
+
+        [[nodiscard]] uint32_t get_sample_rate() const {
+            return m_renderer.get_device_sample_rate();
+        }
+
+    protected:
+        HapticsRenderer m_renderer;
+        std::optional<ma_device> m_device = std::nullopt;
+
+        // Set while we stop the device ourselves, so only stops initiated by the backend are reported as lost
+        std::atomic<bool> m_closing = false;
+        std::atomic<bool> m_suspended = false;
+
+        // Set on the probes of calibrate_period(). Backends reject periods they can't do, so probes fail to open
+        // without reporting an error.
+        bool m_is_probe = false;
+
+        // Callback timing of the probes. Frames delivered minus the time passed since the first callback is how
+        // far the callbacks run ahead of playback; once it falls below zero, the device must have run dry.
+        std::chrono::steady_clock::time_point m_first_callback_time;
+        uint64_t m_delivered_frames = 0;
+        std::atomic<int64_t> m_min_lead_ns = INT64_MAX;
+
+        void uninitialize();
+        void record_callback_timing(ma_uint32 frame_count);
+
+        static void output_data_callback(ma_device* p_device, void* output, const void* input, ma_uint32 p_frame_count);
+        static void device_notification_callback(const ma_device_notification* notification);
+    };
+} // namespace hd_haptics
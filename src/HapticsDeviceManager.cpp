@@ -0,0 +1,267 @@
+#include "HapticsDeviceManager.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <godot_cpp/core/class_db.hpp>
+
+namespace hd_haptics {
+    // Devices are polled quickly right after a change and progressively less often while nothing happens
+    constexpr std::chrono::milliseconds MIN_POLL_INTERVAL(250);
+    constexpr std::chrono::milliseconds MAX_POLL_INTERVAL(2000);
+
+    static HapticsDeviceManager* singleton = nullptr;
+
+    void HapticsDeviceManager::create_singleton() {
+        if (singleton == nullptr) {
+            singleton = new HapticsDeviceManager();
+        }
+    }
+
+    void HapticsDeviceManager::destroy_singleton() {
+        delete singleton;
+        singleton = nullptr;
+    }
+
+    HapticsDeviceManager* HapticsDeviceManager::get_singleton() {
+        return singleton;
+    }
+
+    HapticsDeviceManager::HapticsDeviceManager() {
+        m_thread = std::thread([this] { run(); });
+    }
+
+    void HapticsDeviceManager::initialize_context() {
+        constexpr std::array backends = {
+            ma_backend_pulseaudio,
+            ma_backend_wasapi,
+        };
+
+        m_context = std::make_optional<ma_context>();
+
+        if (ma_context_init(backends.data(), static_cast<ma_uint32>(backends.size()), nullptr, &*m_context) != MA_SUCCESS) {
+            m_context = std::nullopt;
+            ERR_FAIL_MSG("Failed to initialize context.");
+        }
+    }
+
+    HapticsDeviceManager::~HapticsDeviceManager() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake_up.notify_all();
+
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+
+        if (m_context.has_value()) {
+            ma_context_uninit(&*m_context);
+            m_context = std::nullopt;
+        }
+    }
+
+    HapticsDeviceManager::SubscriptionId HapticsDeviceManager::subscribe(Listener listener) {
+        SubscriptionId subscription;
+
+        {
+            std::lock_guard lock(m_mutex);
+            subscription = m_next_subscription++;
+            m_pending_listeners.emplace(subscription, std::move(listener));
+        }
+        m_wake_up.notify_all();
+
+        return subscription;
+    }
+
+    void HapticsDeviceManager::unsubscribe(SubscriptionId subscription) {
+        // Same lock order as the background thread, so a pending listener can't be moved over in between
+        std::lock_guard listener_lock(m_listener_mutex);
+        std::lock_guard lock(m_mutex);
+
+        m_pending_listeners.erase(subscription);
+        m_listeners.erase(subscription);
+        m_has_listeners = !m_listeners.empty();
+    }
+
+    std::vector<HapticsDeviceManager::DeviceInfo> HapticsDeviceManager::get_devices() {
+        std::lock_guard lock(m_mutex);
+        return m_devices;
+    }
+
+    ma_context* HapticsDeviceManager::get_context() {
+        return m_context.has_value() ? &*m_context : nullptr;
+    }
+
+    void HapticsDeviceManager::report_device_lost(const ma_device_id& device_id) {
+        {
+            std::lock_guard lock(m_mutex);
+            m_lost_devices.push_back(device_id);
+        }
+        m_wake_up.notify_all();
+    }
+
+    void HapticsDeviceManager::run() {
+        bool is_context_initialized = false;
+        auto poll_interval = MIN_POLL_INTERVAL;
+
+        std::unique_lock lock(m_mutex);
+
+        while (!m_stop) {
+            if (!m_has_listeners && m_pending_listeners.empty()) {
+                // Nothing is enumerated without subscribers, e.g. in the editor or before the first effect is instantiated
+                m_wake_up.wait(lock, [this] { return m_stop || !m_pending_listeners.empty(); });
+                poll_interval = MIN_POLL_INTERVAL;
+            } else {
+                m_wake_up.wait_for(lock, poll_interval, [this] { return m_stop || !m_lost_devices.empty() || !m_pending_listeners.empty(); });
+            }
+
+            if (m_stop) {
+                break;
+            }
+
+            lock.unlock();
+
+            const bool is_first_refresh = !is_context_initialized;
+            if (is_first_refresh) {
+                initialize_context();
+                is_context_initialized = true;
+            }
+
+            // The cache may be stale after sleeping, so new listeners are only replayed the refreshed devices
+            const bool changed = refresh_devices();
+            add_pending_listeners();
+
+            if (is_first_refresh && get_devices().empty()) {
+                WARN_PRINT("Did not find a compatible Audio Haptics device");
+            }
+
+            lock.lock();
+
+            poll_interval = changed ? MIN_POLL_INTERVAL : std::min(poll_interval * 2, MAX_POLL_INTERVAL);
+        }
+    }
+
+    void HapticsDeviceManager::add_pending_listeners() {
+        std::lock_guard listener_lock(m_listener_mutex);
+
+        std::map<SubscriptionId, Listener> pending_listeners;
+        std::vector<DeviceInfo> devices;
+
+        {
+            std::lock_guard lock(m_mutex);
+            pending_listeners.swap(m_pending_listeners);
+            devices = m_devices;
+        }
+
+        // The listener lock is held since the cache was copied, so these listeners see every device exactly once
+        for (auto& [subscription, listener] : pending_listeners) {
+            for (const auto& device : devices) {
+                listener(DeviceEventType::Connected, device);
+            }
+
+            m_listeners.emplace(subscription, std::move(listener));
+        }
+
+        std::lock_guard lock(m_mutex);
+        m_has_listeners = !m_listeners.empty();
+    }
+
+    bool HapticsDeviceManager::refresh_devices() {
+        if (!m_context.has_value()) {
+            return false;
+        }
+
+        ma_device_info* playback_device_infos;
+        ma_uint32 playback_device_count;
+
+        ma_result result = ma_context_get_devices(&*m_context, &playback_device_infos, &playback_device_count, nullptr, nullptr);
+        ERR_FAIL_COND_V_MSG(result != MA_SUCCESS, false, "Failed to retrieve device information");
+
+        std::vector<DeviceInfo> found_devices;
+
+        for (ma_uint32 i_device = 0; i_device < playback_device_count; ++i_device) {
+            const auto& playback_device_info = playback_device_infos[i_device];
+            std::string name(playback_device_info.name);
+            if (name.contains("DualSense")) {
+                found_devices.push_back({playback_device_info.id, std::move(name)});
+            }
+        }
+
+        auto contains = [](const std::vector<DeviceInfo>& devices, const ma_device_id& device_id) {
+            return std::ranges::any_of(devices, [&](const DeviceInfo& device) { return is_same_device(device.id, device_id); });
+        };
+
+        // Hold the listener lock while updating the cache, so unsubscribe() waits for the notifications below
+        std::lock_guard listener_lock(m_listener_mutex);
+
+        std::vector<DeviceInfo> connected_devices;
+        std::vector<DeviceInfo> disconnected_devices;
+
+        {
+            std::lock_guard lock(m_mutex);
+
+            // Devices stopped by the backend are reported as disconnected, and connected again right away if they are still present
+            for (const auto& lost_device_id : m_lost_devices) {
+                auto it = std::ranges::find_if(m_devices, [&](const DeviceInfo& device) { return is_same_device(device.id, lost_device_id); });
+                if (it != m_devices.end()) {
+                    disconnected_devices.push_back(*it);
+                    m_devices.erase(it);
+                }
+            }
+            m_lost_devices.clear();
+
+            for (const auto& device : m_devices) {
+                if (!contains(found_devices, device.id)) {
+                    disconnected_devices.push_back(device);
+                }
+            }
+
+            for (auto& device : found_devices) {
+                auto it = std::ranges::find_if(m_devices, [&](const DeviceInfo& known_device) { return is_same_device(known_device.id, device.id); });
+                if (it != m_devices.end()) {
+                    device.controller_index = it->controller_index;
+                }
+            }
+
+            for (auto& device : found_devices) {
+                if (device.controller_index >= 0) {
+                    continue;
+                }
+
+                int controller_index = 0;
+                while (std::ranges::any_of(found_devices, [&](const DeviceInfo& other) { return other.controller_index == controller_index; })) {
+                    ++controller_index;
+                }
+
+                device.controller_index = controller_index;
+                connected_devices.push_back(device);
+            }
+
+            m_devices = std::move(found_devices);
+        }
+
+        for (const auto& device : disconnected_devices) {
+            notify(DeviceEventType::Disconnected, device);
+        }
+
+        for (const auto& device : connected_devices) {
+            notify(DeviceEventType::Connected, device);
+        }
+
+        return !connected_devices.empty() || !disconnected_devices.empty();
+    }
+
+    void HapticsDeviceManager::notify(DeviceEventType type, const DeviceInfo& device) {
+        for (const auto& [subscription, listener] : m_listeners) {
+            listener(type, device);
+        }
+    }
+
+    bool HapticsDeviceManager::is_same_device(const ma_device_id& a, const ma_device_id& b) {
+        // This memcmp is safe: https://github.com/mackron/miniaudio/issues/866#issuecomment-2207374206
+        return std::memcmp(&a, &b, sizeof(ma_device_id)) == 0; // NOLINT(*-suspicious-memory-comparison)
+    }
+} // namespace hd_haptics
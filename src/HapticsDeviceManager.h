@@ -0,0 +1,96 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "external/miniaudio_init.h"
+
+namespace hd_haptics {
+    /// Process-wide owner of the miniaudio context. Initializes the context and enumerates playback devices on a
+    /// single background thread, caches the compatible ones and notifies subscribers when a device is connected
+    /// or disconnected. Nothing here waits on the audio server from the calling thread.
+    ///
+    /// The context is only initialized once the first listener subscribes, and devices are only polled while
+    /// there are listeners, so loading the extension alone never talks to the audio server.
+    class HapticsDeviceManager {
+    public:
+        struct DeviceInfo {
+            ma_device_id id;
+            std::string name;
+            // Stable while the device stays connected. A new device gets the lowest free index, like joypads.
+            int controller_index = -1;
+        };
+
+        enum class DeviceEventType {
+            Connected,
+            Disconnected,
+        };
+
+        using SubscriptionId = uint64_t;
+        using Listener = std::function<void(DeviceEventType type, const DeviceInfo& device)>;
+
+        static void create_singleton();
+        static void destroy_singleton();
+        static HapticsDeviceManager* get_singleton();
+
+        HapticsDeviceManager(const HapticsDeviceManager&) = delete;
+        HapticsDeviceManager& operator=(const HapticsDeviceManager&) = delete;
+
+        /// Registers a listener. A connected event for every known device is replayed from the background thread,
+        /// so the listener may open devices without stalling the caller. Listeners are only called from the
+        /// background thread, and not anymore once unsubscribe() returned.
+        SubscriptionId subscribe(Listener listener);
+        void unsubscribe(SubscriptionId subscription);
+
+        [[nodiscard]] std::vector<DeviceInfo> get_devices();
+
+        /// The context devices should be opened with. Null if the context could not be initialized.
+        /// Only to be used from listeners and the threads they start, the context is initialized by the background
+        /// thread before calling any.
+        ma_context* get_context();
+
+        /// Called when the backend stopped an open device on its own. The device is reported as
+        /// disconnected and the device list is refreshed right away instead of on the next poll.
+        void report_device_lost(const ma_device_id& device_id);
+
+        static bool is_same_device(const ma_device_id& a, const ma_device_id& b);
+
+    private:
+        HapticsDeviceManager();
+        ~HapticsDeviceManager();
+
+        void run();
+        void initialize_context();
+        /// Moves new subscriptions to the listeners and replays the known devices to them.
+        void add_pending_listeners();
+        /// Re-enumerates the playback devices and notifies listeners. Returns whether anything changed.
+        bool refresh_devices();
+        void notify(DeviceEventType type, const DeviceInfo& device);
+
+        std::optional<ma_context> m_context = std::nullopt;
+
+        // Guards the cached device list, the pending lost devices and subscriptions and the poller state
+        std::mutex m_mutex;
+        std::condition_variable m_wake_up;
+        std::vector<DeviceInfo> m_devices;
+        std::vector<ma_device_id> m_lost_devices;
+        std::map<SubscriptionId, Listener> m_pending_listeners;
+        SubscriptionId m_next_subscription = 1;
+        // Mirrors whether m_listeners is empty, so the poller can check it without the listener lock
+        bool m_has_listeners = false;
+        bool m_stop = false;
+
+        // Held while listeners are called, serializes events and makes unsubscribe() wait for running callbacks
+        std::mutex m_listener_mutex;
+        std::map<SubscriptionId, Listener> m_listeners;
+
+        std::thread m_thread;
+    };
+} // namespace hd_haptics
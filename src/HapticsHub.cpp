@@ -0,0 +1,502 @@
+#include "HapticsHub.h"
+
+#include <algorithm>
+#include <format>
+#include <iterator>
+#include <godot_cpp/core/class_db.hpp>
+
+#include "HapticsCalibrationStore.h"
+
+namespace hd_haptics {
+    // How often the idle monitor checks for the idle timeout. Waking up is signaled right away instead.
+    constexpr auto IDLE_CHECK_INTERVAL = std::chrono::milliseconds(100);
+
+    static HapticsHub* hub_singleton = nullptr;
+
+    void HapticsHub::create_singleton() {
+        if (hub_singleton == nullptr) {
+            hub_singleton = new HapticsHub();
+        }
+    }
+
+    void HapticsHub::destroy_singleton() {
+        delete hub_singleton;
+        hub_singleton = nullptr;
+    }
+
+    HapticsHub* HapticsHub::get_singleton() {
+        return hub_singleton;
+    }
+
+    HapticsHub::HapticsHub() {
+        m_idle_monitor = std::jthread([this](const std::stop_token& stop_token) { run_idle_monitor(stop_token); });
+    }
+
+    HapticsHub::~HapticsHub() {
+        stop_replay();
+        stop_capture();
+
+        m_idle_monitor.request_stop();
+        wake_up();
+        if (m_idle_monitor.joinable()) {
+            m_idle_monitor.join();
+        }
+
+        if (auto* manager = HapticsDeviceManager::get_singleton(); manager != nullptr && m_device_subscription.has_value()) {
+            manager->unsubscribe(*m_device_subscription);
+        }
+
+        std::vector<Calibration> calibrations;
+        {
+            std::lock_guard lock(m_mutex);
+            calibrations = cancel_calibrations();
+        }
+
+        // The calibration threads open devices themselves until they are joined
+        calibrations.clear();
+
+        std::lock_guard lock(m_mutex);
+        m_devices.clear();
+    }
+
+    std::optional<HapticsHub::LaneId> HapticsHub::add_lane(const std::shared_ptr<HapticsStream>& stream, ControllerListener listener) {
+        auto* manager = HapticsDeviceManager::get_singleton();
+        ERR_FAIL_NULL_V(manager, std::nullopt);
+
+        std::lock_guard lock(m_mutex);
+        ERR_FAIL_COND_V_MSG(m_lanes.size() >= HapticsRenderer::MAX_STREAMS, std::nullopt, "Too many Controller Haptics effects are active.");
+
+        const LaneId lane = m_next_lane++;
+
+        stream->set_wake_handler([this] { wake_up(); });
+        stream->set_suspended(m_suspended);
+        stream->set_live(!m_devices.empty());
+        m_lanes.emplace(lane, Lane{stream, std::move(listener)});
+
+        update_device_streams();
+
+        // Devices are opened on the device manager thread, starting with the first lane
+        if (!m_device_subscription.has_value()) {
+            m_device_subscription = manager->subscribe([this](HapticsDeviceManager::DeviceEventType type, const HapticsDeviceManager::DeviceInfo& device_info) {
+                on_device_event(type, device_info);
+            });
+        }
+
+        return lane;
+    }
+
+    void HapticsHub::remove_lane(LaneId lane) {
+        std::optional<HapticsDeviceManager::SubscriptionId> device_subscription;
+        std::vector<Calibration> calibrations;
+
+        {
+            std::lock_guard lock(m_mutex);
+
+            const auto it = m_lanes.find(lane);
+            if (it == m_lanes.end()) {
+                return;
+            }
+
+            it->second.stream->set_live(false);
+            m_lanes.erase(it);
+            update_device_streams();
+
+            if (m_lanes.empty()) {
+                device_subscription = std::exchange(m_device_subscription, std::nullopt);
+                calibrations = cancel_calibrations();
+            }
+        }
+
+        // Listeners are called after m_mutex is released. Waiting for the ones running, which may still include this
+        // lane, makes sure it is not called anymore.
+        {
+            std::lock_guard listener_lock(m_listener_mutex);
+        }
+
+        if (!device_subscription.has_value()) {
+            return;
+        }
+
+        // Unsubscribing waits for running device events, which need m_mutex, so it can't be held here
+        if (auto* manager = HapticsDeviceManager::get_singleton()) {
+            manager->unsubscribe(*device_subscription);
+        }
+
+        std::vector<std::unique_ptr<HapticsDevice>> devices;
+
+        {
+            std::lock_guard lock(m_mutex);
+            if (m_lanes.empty()) {
+                devices = std::move(m_devices);
+                m_devices.clear();
+
+                // The last device event may have started another calibration before unsubscribing returned
+                std::ranges::move(cancel_calibrations(), std::back_inserter(calibrations));
+            }
+        }
+
+        // Closing waits for the device and calibration threads, so do it outside the lock
+        calibrations.clear();
+        devices.clear();
+    }
+
+    bool HapticsHub::start_capture(const std::filesystem::path& path) {
+        stop_capture();
+
+        std::lock_guard lock(m_mutex);
+
+        if (!m_recorder.start(path)) {
+            return false;
+        }
+
+        for (const auto& device : m_devices) {
+            device->set_capture_tap(m_recorder.create_tap(device->get_controller_index(), device->get_sample_rate()));
+        }
+
+        return true;
+    }
+
+    void HapticsHub::stop_capture() {
+        std::lock_guard lock(m_mutex);
+
+        // Taps stay attached after a failed write until the recording is stopped here
+        for (const auto& device : m_devices) {
+            device->set_capture_tap(nullptr);
+        }
+
+        if (const uint64_t dropped_chunks = m_recorder.get_dropped_chunks(); dropped_chunks > 0) {
+            WARN_PRINT(std::format("Haptics capture fell behind and dropped {} chunks.", dropped_chunks).c_str());
+        }
+
+        if (m_recorder.is_recording() && m_recorder.has_failed()) {
+            WARN_PRINT("Writing the haptics capture failed, the capture file ends early.");
+        }
+
+        m_recorder.stop();
+    }
+
+    bool HapticsHub::is_capturing() {
+        std::lock_guard lock(m_mutex);
+        return m_recorder.is_recording() && !m_recorder.has_failed();
+    }
+
+    bool HapticsHub::start_replay(const std::filesystem::path& path, int source_controller) {
+        stop_replay();
+
+        auto replay = std::make_unique<HapticsReplay>();
+        if (!replay->open(path, source_controller)) {
+            return false;
+        }
+
+        const std::optional<LaneId> lane = add_lane(replay->get_stream(), [](int, bool) {});
+        if (!lane.has_value()) {
+            return false;
+        }
+
+        replay->start();
+
+        std::lock_guard lock(m_replay_mutex);
+        m_replay = std::move(replay);
+        m_replay_lane = lane;
+
+        return true;
+    }
+
+    void HapticsHub::stop_replay() {
+        std::unique_ptr<HapticsReplay> replay;
+        std::optional<LaneId> lane;
+
+        {
+            std::lock_guard lock(m_replay_mutex);
+            replay = std::move(m_replay);
+            lane = std::exchange(m_replay_lane, std::nullopt);
+        }
+
+        // Stop writing before the lane goes away, then stop mixing the stream
+        replay.reset();
+
+        if (lane.has_value()) {
+            remove_lane(*lane);
+        }
+    }
+
+    bool HapticsHub::is_replaying() {
+        std::lock_guard lock(m_replay_mutex);
+        return m_replay != nullptr && !m_replay->is_finished();
+    }
+
+    void HapticsHub::set_device_settings(const DeviceSettings& settings) {
+        std::lock_guard lock(m_mutex);
+
+        if (!m_lanes.empty() && settings != m_device_settings) {
+            WARN_PRINT("Controller Haptics effects with different device settings are active, devices opened from now on use the latest ones.");
+        }
+
+        m_device_settings = settings;
+    }
+
+    std::vector<int> HapticsHub::get_open_controllers() {
+        std::vector<int> controllers;
+
+        std::lock_guard lock(m_mutex);
+        for (const auto& device : m_devices) {
+            controllers.push_back(device->get_controller_index());
+        }
+
+        return controllers;
+    }
+
+    void HapticsHub::on_device_event(HapticsDeviceManager::DeviceEventType type, const HapticsDeviceManager::DeviceInfo& device_info) {
+        if (type == HapticsDeviceManager::DeviceEventType::Connected) {
+            open_device(device_info);
+        } else {
+            close_device(device_info);
+        }
+    }
+
+    void HapticsHub::open_device(const HapticsDeviceManager::DeviceInfo& device_info) {
+        auto* manager = HapticsDeviceManager::get_singleton();
+        ERR_FAIL_NULL(manager);
+
+        DeviceSettings settings;
+
+        {
+            std::lock_guard lock(m_mutex);
+
+            // A device may be replayed to a new subscription while the devices of the previous one are still open
+            const bool is_open =
+                std::ranges::any_of(m_devices, [&](const std::unique_ptr<HapticsDevice>& device) { return device->is_device(device_info.id); });
+            if (m_lanes.empty() || is_open) {
+                return;
+            }
+
+            settings = m_device_settings;
+        }
+
+        if (ma_context* context = manager->get_context(); settings.calibrate_period && context != nullptr) {
+            const std::string device_key = HapticsCalibrationStore::get_device_key(*context, device_info.id, settings.device.share_mode);
+
+            const std::optional<uint32_t> period_ms = HapticsCalibrationStore::load_period_ms(device_key);
+            if (!period_ms.has_value()) {
+                start_calibration(device_info, settings.device, device_key);
+                return;
+            }
+
+            settings.device.period_ms = *period_ms;
+        }
+
+        add_device(device_info, settings.device, {});
+    }
+
+    void HapticsHub::add_device(const HapticsDeviceManager::DeviceInfo& device_info, HapticsDevice::Settings settings, const std::stop_token& stop_token) {
+        // Opening talks to the audio server, keep the lanes and devices available meanwhile
+        auto device = std::make_unique<HapticsDevice>();
+        bool initialized = device->initialize(device_info.id, device_info.controller_index, settings);
+
+        // PulseAudio has no exclusive mode, fall back instead of leaving the controller silent
+        if (!initialized && settings.share_mode == ma_share_mode_exclusive) {
+            WARN_PRINT("Opening the haptics device in exclusive mode failed, falling back to shared mode.");
+            settings.share_mode = ma_share_mode_shared;
+            initialized = device->initialize(device_info.id, device_info.controller_index, settings);
+        }
+
+        if (!initialized) {
+            return;
+        }
+
+        // Keeps the listeners of this and other device events in order
+        std::lock_guard listener_lock(m_listener_mutex);
+        std::vector<ControllerListener> listeners;
+
+        {
+            std::lock_guard lock(m_mutex);
+
+            // Cancelled calibrations must not open a device that went away, or that no lane needs anymore
+            if (m_lanes.empty() || stop_token.stop_requested()) {
+                return;
+            }
+
+            // A calibration finishing while a rescan opens the controller with the stored period must not open it twice
+            const bool is_open = std::ranges::any_of(m_devices, [&](const std::unique_ptr<HapticsDevice>& other) {
+                return other->is_device(device_info.id) || other->get_controller_index() == device_info.controller_index;
+            });
+            if (is_open) {
+                return;
+            }
+
+            // Controllers connected while idle join the others in suspension until there is something to play
+            if (m_suspended) {
+                device->suspend();
+            }
+
+            if (m_recorder.is_recording()) {
+                device->set_capture_tap(m_recorder.create_tap(device_info.controller_index, device->get_sample_rate()));
+            }
+
+            m_devices.push_back(std::move(device));
+            update_device_streams();
+
+            for (auto& [lane_id, lane] : m_lanes) {
+                lane.stream->set_live(true);
+                lane.stream->get_stats().record_device_connected();
+                listeners.push_back(lane.listener);
+            }
+        }
+
+        for (const auto& listener : listeners) {
+            listener(device_info.controller_index, true);
+        }
+
+        WARN_PRINT("Audio Haptics device connected");
+    }
+
+    void HapticsHub::start_calibration(
+        const HapticsDeviceManager::DeviceInfo& device_info,
+        const HapticsDevice::Settings& settings,
+        const std::string& device_key
+    ) {
+        std::lock_guard lock(m_mutex);
+
+        // A device reported again while it is still calibrating is opened by that calibration
+        const bool is_calibrating = std::ranges::any_of(m_calibrations, [&](const Calibration& calibration) {
+            return HapticsDeviceManager::is_same_device(calibration.device_id, device_info.id);
+        });
+        if (m_lanes.empty() || is_calibrating) {
+            return;
+        }
+
+        WARN_PRINT(std::format("Calibrating the period of haptics device \"{}\", this takes a few seconds once.", device_info.name).c_str());
+
+        std::jthread thread([this, device_info, settings, device_key](const std::stop_token& stop_token) {
+            run_calibration(device_info, settings, device_key, stop_token);
+        });
+        m_calibrations.push_back({device_info.id, std::move(thread)});
+    }
+
+    void HapticsHub::run_calibration(
+        const HapticsDeviceManager::DeviceInfo& device_info,
+        const HapticsDevice::Settings& settings,
+        const std::string& device_key,
+        const std::stop_token& stop_token
+    ) {
+        const std::optional<uint32_t> period_ms = HapticsDevice::calibrate_period(device_info.id, settings, stop_token);
+
+        // Cancelled, the device calibrates again the next time it is opened
+        if (!period_ms.has_value()) {
+            return;
+        }
+
+        HapticsCalibrationStore::save_period_ms(device_key, *period_ms);
+
+        HapticsDevice::Settings calibrated_settings = settings;
+        calibrated_settings.period_ms = *period_ms;
+        add_device(device_info, calibrated_settings, stop_token);
+    }
+
+    std::vector<HapticsHub::Calibration> HapticsHub::cancel_calibrations() {
+        for (auto& calibration : m_calibrations) {
+            calibration.thread.request_stop();
+        }
+
+        return std::exchange(m_calibrations, {});
+    }
+
+    void HapticsHub::close_device(const HapticsDeviceManager::DeviceInfo& device_info) {
+        std::unique_ptr<HapticsDevice> closed_device;
+        std::jthread cancelled_calibration;
+        std::vector<ControllerListener> listeners;
+
+        // The calibration may be waiting for m_listener_mutex to open the device, so it is joined after releasing it
+        std::unique_lock listener_lock(m_listener_mutex);
+
+        {
+            std::lock_guard lock(m_mutex);
+
+            // A device that went away can't be calibrated, joining the calibration waits for its last probe to close
+            const auto calibration = std::ranges::find_if(m_calibrations, [&](const Calibration& other) {
+                return HapticsDeviceManager::is_same_device(other.device_id, device_info.id);
+            });
+            if (calibration != m_calibrations.end()) {
+                calibration->thread.request_stop();
+                cancelled_calibration = std::move(calibration->thread);
+                m_calibrations.erase(calibration);
+            }
+
+            const auto it = std::ranges::find_if(m_devices, [&](const std::unique_ptr<HapticsDevice>& device) { return device->is_device(device_info.id); });
+            if (it == m_devices.end()) {
+                listener_lock.unlock();
+                return;
+            }
+
+            closed_device = std::move(*it);
+            m_devices.erase(it);
+
+            for (auto& [lane_id, lane] : m_lanes) {
+                lane.stream->set_live(!m_devices.empty());
+                lane.stream->get_stats().record_device_disconnected();
+                listeners.push_back(lane.listener);
+            }
+        }
+
+        for (const auto& listener : listeners) {
+            listener(device_info.controller_index, false);
+        }
+
+        listener_lock.unlock();
+        closed_device.reset();
+        WARN_PRINT("Audio Haptics device disconnected");
+    }
+
+    void HapticsHub::update_device_streams() {
+        std::vector<std::shared_ptr<HapticsStream>> streams;
+        streams.reserve(m_lanes.size());
+
+        for (const auto& [lane_id, lane] : m_lanes) {
+            streams.push_back(lane.stream);
+        }
+
+        for (const auto& device : m_devices) {
+            device->set_streams(streams);
+        }
+    }
+
+    void HapticsHub::wake_up() {
+        if (!m_wake_requested.exchange(true)) {
+            m_wake_semaphore.release();
+        }
+    }
+
+    void HapticsHub::run_idle_monitor(const std::stop_token& stop_token) {
+        while (!stop_token.stop_requested()) {
+            if (m_wake_semaphore.try_acquire_for(IDLE_CHECK_INTERVAL)) {
+                m_wake_requested.store(false);
+            }
+
+            if (stop_token.stop_requested()) {
+                break;
+            }
+
+            std::lock_guard lock(m_mutex);
+
+            const bool idle = !m_lanes.empty() && std::ranges::all_of(m_lanes, [](const auto& lane) { return lane.second.stream->is_idle(); });
+            if (idle == m_suspended) {
+                continue;
+            }
+
+            for (const auto& device : m_devices) {
+                if (idle) {
+                    device->suspend();
+                } else {
+                    device->resume();
+                }
+            }
+
+            m_suspended = idle;
+            for (auto& [lane_id, lane] : m_lanes) {
+                lane.stream->set_suspended(idle);
+            }
+
+            (idle ? m_suspend_count : m_wake_up_count).fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+} // namespace hd_haptics
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <semaphore>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "HapticsCapture.h"
+#include "HapticsDevice.h"
+#include "HapticsDeviceManager.h"
+#include "HapticsReplay.h"
+#include "HapticsStream.h"
+
+namespace hd_haptics {
+    /// Process-wide owner of the opened haptics devices. Every effect instance adds its stream as a lane, and
+    /// each controller gets exactly one device that mixes all lanes, no matter how many buses feed it.
+    ///
+    /// Devices are opened once the first lane is added and closed when the last one is removed. They are
+    /// suspended while every lane has been idle for its idle timeout. Devices that need a period calibration are
+    /// calibrated and opened on a thread of their own.
+    class HapticsHub {
+    public:
+        using LaneId = uint64_t;
+        /// Called when a controller of the lane becomes live or goes away.
+        using ControllerListener = std::function<void(int controller_index, bool connected)>;
+
+        struct DeviceSettings {
+            HapticsDevice::Settings device;
+            /// Replaces the period of `device` with the calibrated one, calibrating devices seen for the first time.
+            bool calibrate_period = false;
+
+            bool operator==(const DeviceSettings&) const = default;
+        };
+
+        static void create_singleton();
+        static void destroy_singleton();
+        static HapticsHub* get_singleton();
+
+        HapticsHub(const HapticsHub&) = delete;
+        HapticsHub& operator=(const HapticsHub&) = delete;
+
+        /// Starts mixing `stream` into every controller. The listener is called from the device manager thread or a
+        /// calibration thread, and not anymore once remove_lane() returned.
+        std::optional<LaneId> add_lane(const std::shared_ptr<HapticsStream>& stream, ControllerListener listener);
+
+        /// Stops mixing the lane. Returns once no device callback uses its stream anymore.
+        void remove_lane(LaneId lane);
+
+        /// Applies to devices opened from now on, devices already open keep their configuration. The devices are shared,
+        /// so there is only one configuration for all lanes; changing it while lanes are active warns.
+        void set_device_settings(const DeviceSettings& settings);
+
+        /// Indices of the controllers a device is open for.
+        [[nodiscard]] std::vector<int> get_open_controllers();
+
+        /// Records what every device renders to a capture file, until stop_capture().
+        bool start_capture(const std::filesystem::path& path);
+        void stop_capture();
+        /// False once writing the capture failed, stop_capture() still has to be called.
+        [[nodiscard]] bool is_capturing();
+
+        /// Plays what `source_controller` rendered in a capture file on every controller, as an additional lane.
+        bool start_replay(const std::filesystem::path& path, int source_controller);
+        void stop_replay();
+        [[nodiscard]] bool is_replaying();
+
+        [[nodiscard]] uint64_t get_suspend_count() const {
+            return m_suspend_count.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] uint64_t get_wake_up_count() const {
+            return m_wake_up_count.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Lane {
+            std::shared_ptr<HapticsStream> stream;
+            ControllerListener listener;
+        };
+
+        struct Calibration {
+            ma_device_id device_id;
+            std::jthread thread;
+        };
+
+        HapticsHub();
+        ~HapticsHub();
+
+        void on_device_event(HapticsDeviceManager::DeviceEventType type, const HapticsDeviceManager::DeviceInfo& device_info);
+        void open_device(const HapticsDeviceManager::DeviceInfo& device_info);
+        /// Opens the device with `settings` and hands it the lanes, unless `stop_token` was stopped meanwhile.
+        void add_device(const HapticsDeviceManager::DeviceInfo& device_info, HapticsDevice::Settings settings, const std::stop_token& stop_token);
+        void close_device(const HapticsDeviceManager::DeviceInfo& device_info);
+
+        /// Calibrates the period of a device on a new thread, then opens the device with it.
+        void start_calibration(const HapticsDeviceManager::DeviceInfo& device_info, const HapticsDevice::Settings& settings, const std::string& device_key);
+        void run_calibration(
+            const HapticsDeviceManager::DeviceInfo& device_info,
+            const HapticsDevice::Settings& settings,
+            const std::string& device_key,
+            const std::stop_token& stop_token
+        );
+        /// Stops every calibration and hands over their threads, to be joined without m_mutex held. Must be called
+        /// with m_mutex held.
+        std::vector<Calibration> cancel_calibrations();
+
+        /// Hands the current lanes to every device. Must be called with m_mutex held.
+        void update_device_streams();
+
+        /// Asks the idle monitor to check the lanes right away. Never blocks.
+        void wake_up();
+        void run_idle_monitor(const std::stop_token& stop_token);
+
+        // Held while calling the lane listeners, which happens without m_mutex. Taken before m_mutex.
+        std::mutex m_listener_mutex;
+
+        // Guards the lanes, the devices and the suspension state
+        std::mutex m_mutex;
+        std::map<LaneId, Lane> m_lanes;
+        LaneId m_next_lane = 1;
+        std::vector<std::unique_ptr<HapticsDevice>> m_devices;
+        std::optional<HapticsDeviceManager::SubscriptionId> m_device_subscription = std::nullopt;
+        DeviceSettings m_device_settings;
+        bool m_suspended = false;
+        // Calibrating takes seconds, which would hold up every other device event
+        std::vector<Calibration> m_calibrations;
+
+        // Devices get a tap while recording. Replays are added as a lane like an effect instance.
+        HapticsRecorder m_recorder;
+        std::mutex m_replay_mutex;
+        std::unique_ptr<HapticsReplay> m_replay;
+        std::optional<LaneId> m_replay_lane = std::nullopt;
+
+        // Lanes wake the devices from `_process` and the device callbacks, so signaling the idle monitor must never
+        // block. Only the first request since the monitor last woke up releases the semaphore, keeping it binary.
+        std::binary_semaphore m_wake_semaphore{0};
+        std::atomic<bool> m_wake_requested = false;
+
+        // Suspends the devices once every lane has been idle for its idle timeout, and resumes them on activity
+        std::jthread m_idle_monitor;
+        std::atomic<uint64_t> m_suspend_count = 0;
+        std::atomic<uint64_t> m_wake_up_count = 0;
+    };
+} // namespace hd_haptics
@@ -0,0 +1,186 @@
+#include "HapticsRenderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "SilenceDetection.h"
+
+namespace hd_haptics {
+    constexpr uint32_t CONVERSION_CHUNK_FRAMES = 256;
+    static_assert(CONVERSION_CHUNK_FRAMES <= HapticsCaptureTap::SLOT_FRAMES, "Every chunk must fit a capture slot");
+
+    HapticsRenderer::~HapticsRenderer() = default;
+
+    void HapticsRenderer::initialize(int controller_index, uint32_t device_sample_rate) {
+        m_controller_index = controller_index;
+        m_device_sample_rate = device_sample_rate;
+    }
+
+    void HapticsRenderer::set_streams(const std::vector<std::shared_ptr<HapticsStream>>& streams) {
+        auto lane_set = std::make_unique<LaneSet>();
+
+        for (const auto& stream : streams) {
+            auto it = std::ranges::find_if(m_lane_set_owner->lanes, [&](const std::shared_ptr<Lane>& lane) { return lane->stream == stream; });
+
+            if (it != m_lane_set_owner->lanes.end()) {
+                lane_set->lanes.push_back(*it);
+                continue;
+            }
+
+            const HapticsStream::Config& config = stream->get_config();
+            auto lane = std::make_shared<Lane>();
+            lane->stream = stream;
+            lane->reader.attach(stream->get_ring_buffer());
+            lane->drift_compensator.reset(config.target_frames, config.sample_rate, m_device_sample_rate, config.time_stretch, config.resampler_quality);
+            lane->voices.attach(stream->get_clip_queue(), static_cast<double>(config.sample_rate) / m_device_sample_rate);
+            lane_set->lanes.push_back(std::move(lane));
+        }
+
+        m_lane_set.store(lane_set.get());
+
+        // A render() call that started before the swap may still use the previous set
+        wait_for_render();
+        m_lane_set_owner = std::move(lane_set);
+    }
+
+    void HapticsRenderer::set_capture_tap(std::shared_ptr<HapticsCaptureTap> tap) {
+        m_capture_tap.store(tap.get());
+
+        wait_for_render();
+        m_capture_tap_owner = std::move(tap);
+    }
+
+    void HapticsRenderer::wait_for_render() const {
+        if (const uint64_t epoch = m_render_epoch.load(); epoch % 2 == 1) {
+            while (m_render_epoch.load() == epoch) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void HapticsRenderer::render(float* p_output, uint32_t frame_count) {
+        const auto start_time = std::chrono::steady_clock::now();
+
+        m_render_epoch.fetch_add(1);
+        const LaneSet& lane_set = *m_lane_set.load();
+        HapticsCaptureTap* capture_tap = m_capture_tap.load();
+
+        struct LaneState {
+            bool is_routed;
+            int priority;
+            float ducking_gain;
+            std::array<float, INPUT_CHANNELS> gains;
+        };
+
+        // Read the settings once per callback, they change at most once per Godot mix block
+        std::array<LaneState, MAX_STREAMS> lane_states; // NOLINT(*-member-init)
+        const size_t lane_count = std::min(lane_set.lanes.size(), MAX_STREAMS);
+
+        for (size_t i_lane = 0; i_lane < lane_count; ++i_lane) {
+            Lane& lane = *lane_set.lanes[i_lane];
+            lane_states[i_lane] = {
+                lane.stream->is_routed_to(m_controller_index),
+                lane.stream->get_priority(),
+                lane.stream->get_ducking_gain(),
+                lane.stream->get_channel_gains(),
+            };
+
+            // Clips requested since the last callback start playing right away, within this device period
+            lane.voices.poll(m_controller_index);
+
+            // Playing clips keep the devices awake just like audio coming from the bus
+            if (lane.voices.is_playing()) {
+                lane.stream->mark_active();
+            }
+        }
+
+        std::array<float, CONVERSION_CHUNK_FRAMES * INPUT_CHANNELS> lane_buffer; // NOLINT(*-member-init)
+        std::array<float, CONVERSION_CHUNK_FRAMES * INPUT_CHANNELS> mix_buffer;  // NOLINT(*-member-init)
+        uint32_t frames_written = 0;
+
+        while (frames_written < frame_count) {
+            const uint32_t frames_to_write = std::min(frame_count - frames_written, CONVERSION_CHUNK_FRAMES);
+            const size_t sample_count = static_cast<size_t>(frames_to_write) * INPUT_CHANNELS;
+            int highest_audible_priority = INT_MIN;
+
+            std::fill_n(mix_buffer.begin(), sample_count, 0.0f);
+
+            for (size_t i_lane = 0; i_lane < lane_count; ++i_lane) {
+                Lane& lane = *lane_set.lanes[i_lane];
+                const LaneState& state = lane_states[i_lane];
+
+                // The stream keeps being consumed while it is routed elsewhere, so it is in sync when routed back here
+                uint32_t frames_read = lane.drift_compensator.process(lane.reader, lane_buffer.data(), frames_to_write);
+                if (!state.is_routed) {
+                    frames_read = 0;
+                }
+
+                // Pad underruns with silence, the voices are still mixed on top
+                std::fill(lane_buffer.begin() + frames_read * INPUT_CHANNELS, lane_buffer.begin() + sample_count, 0.0f);
+                lane.voices.mix(lane_buffer.data(), frames_to_write);
+
+                if (!is_silent(lane_buffer.data(), sample_count)) {
+                    highest_audible_priority = std::max(highest_audible_priority, state.priority);
+                }
+
+                // Ramp the ducking over the chunk to avoid steps
+                const float target_ducking = state.priority < m_highest_audible_priority ? state.ducking_gain : 1.0f;
+                const float ducking_step = (target_ducking - lane.ducking) / static_cast<float>(frames_to_write);
+
+                for (uint32_t frame = 0; frame < frames_to_write; ++frame) {
+                    const float ducking = lane.ducking + ducking_step * static_cast<float>(frame + 1);
+
+                    for (int channel = 0; channel < INPUT_CHANNELS; ++channel) {
+                        mix_buffer[frame * INPUT_CHANNELS + channel] += lane_buffer[frame * INPUT_CHANNELS + channel] * state.gains[channel] * ducking;
+                    }
+                }
+
+                lane.ducking = target_ducking;
+            }
+
+            m_highest_audible_priority = highest_audible_priority;
+
+            if (capture_tap != nullptr) {
+                const auto timestamp = start_time + std::chrono::nanoseconds(static_cast<uint64_t>(frames_written) * 1'000'000'000 / m_device_sample_rate);
+                capture_tap->push(
+                    mix_buffer.data(),
+                    frames_to_write,
+                    static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count()),
+                    m_rendered_frames + frames_written
+                );
+            }
+
+            Converter::process(p_output + static_cast<size_t>(frames_written) * OUTPUT_CHANNELS, mix_buffer.data(), frames_to_write);
+
+            frames_written += frames_to_write;
+        }
+
+        m_rendered_frames += frame_count;
+        const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time);
+
+        for (size_t i_lane = 0; i_lane < lane_count; ++i_lane) {
+            Lane& lane = *lane_set.lanes[i_lane];
+            HapticsStats& stats = lane.stream->get_stats();
+            const DriftCompensator::Events events = lane.drift_compensator.take_events();
+
+            if (events.dropped_frames > 0) {
+                stats.add_dropped_frames(events.dropped_frames);
+                stats.add_overruns(events.overruns);
+            }
+
+            if (events.underruns > 0 && !lane.stream->is_gated()) {
+                stats.add_underruns(events.underruns);
+            }
+
+            // Latency is reported at the stream rate
+            const uint32_t sample_rate = lane.stream->get_config().sample_rate;
+            const uint32_t fill_level = lane.drift_compensator.get_fill_level();
+            const auto device_buffer_frames = static_cast<uint32_t>(static_cast<uint64_t>(m_device_buffer_frames) * sample_rate / m_device_sample_rate);
+            const uint32_t latency = fill_level + lane.drift_compensator.get_resampler_latency_frames() + device_buffer_frames;
+            stats.record_callback(static_cast<uint64_t>(duration.count()), frame_count, fill_level, latency);
+        }
+
+        m_render_epoch.fetch_add(1);
+    }
+} // namespace hd_haptics
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ChannelConverter.h"
+#include "DriftCompensator.h"
+#include "HapticsCapture.h"
+#include "HapticsStream.h"
+#include "HapticsVoicePool.h"
+
+namespace hd_haptics {
+    /// Renders the audio of one controller: reads every HapticsStream fed to the controller at the pace of the
+    /// device, converts each to the device rate while compensating its drift, mixes in the clips played directly on the device, sums the
+    /// streams with their gains and priority ducking and converts the result to the device channel layout.
+    ///
+    /// Doesn't depend on miniaudio devices or Godot, so anything that calls render() at a steady pace can
+    /// stand in for the hardware.
+    class HapticsRenderer {
+    public:
+        static constexpr int INPUT_CHANNELS = 2;
+        static constexpr int OUTPUT_CHANNELS = 4;
+
+        /// Streams beyond this are not mixed. Keeps the per-callback state on the stack.
+        static constexpr size_t MAX_STREAMS = 16;
+
+        // The DualSense exposes its voice coil actuators as the back pair of a quad device, the front pair stays silent
+        using Converter = ChannelConverter<INPUT_CHANNELS, OUTPUT_CHANNELS, std::array{SILENT_CHANNEL, SILENT_CHANNEL, 0, 1}>;
+
+        HapticsRenderer() = default;
+        ~HapticsRenderer();
+
+        HapticsRenderer(const HapticsRenderer&) = delete;
+        HapticsRenderer& operator=(const HapticsRenderer&) = delete;
+
+        /// `device_sample_rate` is the rate render() produces frames at. Every stream is converted from its own rate.
+        void initialize(int controller_index, uint32_t device_sample_rate);
+
+        /// Replaces the streams mixed by render(). Streams that were already mixed keep their read position.
+        /// Returns once a render() call in progress no longer uses the previous streams. Must not be called
+        /// concurrently with itself.
+        void set_streams(const std::vector<std::shared_ptr<HapticsStream>>& streams);
+
+        /// Starts handing every rendered stereo frame to `tap`, or stops with null. Returns once a render() call in
+        /// progress no longer uses the previous tap. Must not be called concurrently with set_streams().
+        void set_capture_tap(std::shared_ptr<HapticsCaptureTap> tap);
+
+        /// Frames queued downstream of render(), at the device rate. Only used to report the end-to-end latency.
+        void set_device_buffer_frames(uint32_t frame_count) {
+            m_device_buffer_frames = frame_count;
+        }
+
+        /// Fills `p_output` with `frame_count` interleaved frames of OUTPUT_CHANNELS channels.
+        void render(float* p_output, uint32_t frame_count);
+
+        [[nodiscard]] int get_controller_index() const {
+            return m_controller_index;
+        }
+
+        [[nodiscard]] uint32_t get_device_sample_rate() const {
+            return m_device_sample_rate;
+        }
+
+    private:
+        /// Returns once a render() call that may have started before now has finished.
+        void wait_for_render() const;
+
+        /// Everything needed to read one stream on this controller.
+        struct Lane {
+            std::shared_ptr<HapticsStream> stream;
+            BroadcastRingBuffer::Reader reader;
+            DriftCompensator drift_compensator;
+            HapticsVoicePool voices;
+            float ducking = 1.0f;
+        };
+
+        // Published to render() as a whole, so the audio thread never sees a lane list that is being modified
+        struct LaneSet {
+            std::vector<std::shared_ptr<Lane>> lanes;
+        };
+
+        int m_controller_index = -1;
+        uint32_t m_device_sample_rate = 0;
+        uint32_t m_device_buffer_frames = 0;
+
+        std::unique_ptr<LaneSet> m_lane_set_owner = std::make_unique<LaneSet>();
+        std::atomic<LaneSet*> m_lane_set = m_lane_set_owner.get();
+        // Odd while render() runs, lets set_streams() know when the previous lane set is no longer in use
+        std::atomic<uint64_t> m_render_epoch = 0;
+
+        std::shared_ptr<HapticsCaptureTap> m_capture_tap_owner;
+        std::atomic<HapticsCaptureTap*> m_capture_tap = nullptr;
+        // Frames rendered since the device was opened, lets captures reveal dropped chunks
+        uint64_t m_rendered_frames = 0;
+
+        // Only used by render(). Streams are ducked based on which streams were audible in the previous chunk.
+        int m_highest_audible_priority = INT_MIN;
+    };
+} // namespace hd_haptics
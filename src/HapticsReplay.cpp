@@ -0,0 +1,125 @@
+#include "HapticsReplay.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <limits>
+#include <mutex>
+
+namespace hd_haptics {
+    // Chunks are written a little ahead of their time, the stream latency absorbs the sleep jitter
+    constexpr auto REPLAY_INTERVAL = std::chrono::milliseconds(5);
+    constexpr double REPLAY_LATENCY_MS = 30.0;
+    // Lets the devices suspend once the replay has finished, unless an effect instance keeps them busy
+    constexpr auto REPLAY_IDLE_TIMEOUT = std::chrono::seconds(1);
+
+    HapticsReplay::~HapticsReplay() {
+        if (m_thread.joinable()) {
+            m_thread.request_stop();
+            m_thread.join();
+        }
+    }
+
+    bool HapticsReplay::open(const std::filesystem::path& path, int source_controller) {
+        if (!m_file.open(path)) {
+            return false;
+        }
+
+        const uint8_t* p_data = m_file.get_data();
+        const size_t size = m_file.get_size();
+
+        capture_format::FileHeader file_header;
+        if (size < sizeof(file_header)) {
+            return false;
+        }
+
+        std::memcpy(&file_header, p_data, sizeof(file_header));
+        if (file_header.magic != capture_format::FILE_MAGIC || file_header.version != capture_format::VERSION ||
+            file_header.channels != capture_format::CHANNELS) {
+            return false;
+        }
+
+        uint32_t sample_rate = 0;
+
+        // A capture cut short by a crash ends in a partial chunk, replay everything before it
+        for (size_t offset = sizeof(file_header); offset + sizeof(capture_format::ChunkHeader) <= size;) {
+            capture_format::ChunkHeader chunk_header;
+            std::memcpy(&chunk_header, p_data + offset, sizeof(chunk_header));
+
+            const size_t chunk_size = sizeof(chunk_header) + static_cast<size_t>(chunk_header.frame_count) * capture_format::CHANNELS * sizeof(float);
+            if (chunk_header.magic != capture_format::CHUNK_MAGIC || offset + chunk_size > size) {
+                break;
+            }
+
+            // Chunks of another sample rate belong to a device that was replaced by another one in between
+            if (chunk_header.controller_index == source_controller && (sample_rate == 0 || chunk_header.sample_rate == sample_rate)) {
+                sample_rate = chunk_header.sample_rate;
+                m_chunk_offsets.push_back(offset);
+            }
+
+            offset += chunk_size;
+        }
+
+        if (m_chunk_offsets.empty() || sample_rate == 0) {
+            return false;
+        }
+
+        HapticsStream::Config config;
+        config.sample_rate = sample_rate;
+        config.target_frames = static_cast<uint32_t>(REPLAY_LATENCY_MS * sample_rate / 1000.0);
+
+        m_stream = std::make_shared<HapticsStream>(config);
+        m_stream->set_controller_mask(std::numeric_limits<uint32_t>::max());
+        m_stream->set_idle_timeout(REPLAY_IDLE_TIMEOUT);
+        m_writer.initialize(m_stream);
+
+        return true;
+    }
+
+    void HapticsReplay::start() {
+        m_thread = std::jthread([this](const std::stop_token& stop_token) { run(stop_token); });
+    }
+
+    void HapticsReplay::run(const std::stop_token& stop_token) {
+        std::mutex mutex;
+        std::condition_variable_any wake_up;
+
+        auto wait = [&] {
+            std::unique_lock lock(mutex);
+            wake_up.wait_for(lock, stop_token, REPLAY_INTERVAL, [] { return false; });
+        };
+
+        // Devices are opened in the background, the replay starts once the first one reads the stream
+        while (!stop_token.stop_requested() && !m_stream->is_live()) {
+            wait();
+        }
+
+        const uint8_t* p_data = m_file.get_data();
+        capture_format::ChunkHeader first_chunk;
+        std::memcpy(&first_chunk, p_data + m_chunk_offsets.front(), sizeof(first_chunk));
+
+        const auto start_time = std::chrono::steady_clock::now();
+        size_t chunk = 0;
+
+        while (!stop_token.stop_requested() && chunk < m_chunk_offsets.size()) {
+            const auto elapsed = std::chrono::steady_clock::now() - start_time + REPLAY_INTERVAL;
+
+            for (; chunk < m_chunk_offsets.size(); ++chunk) {
+                capture_format::ChunkHeader chunk_header;
+                std::memcpy(&chunk_header, p_data + m_chunk_offsets[chunk], sizeof(chunk_header));
+
+                if (std::chrono::nanoseconds(chunk_header.timestamp_ns - first_chunk.timestamp_ns) > elapsed) {
+                    break;
+                }
+
+                // The frames are written from the mapping as they are, the capture already holds float frames
+                const auto* p_frames = reinterpret_cast<const float*>(p_data + m_chunk_offsets[chunk] + sizeof(chunk_header));
+                m_writer.write(p_frames, chunk_header.frame_count);
+            }
+
+            wait();
+        }
+
+        m_finished.store(true);
+    }
+} // namespace hd_haptics
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include "HapticsCapture.h"
+#include "HapticsStream.h"
+#include "HapticsStreamWriter.h"
+#include "MappedFile.h"
+
+namespace hd_haptics {
+    /// Plays the frames one controller rendered in a capture file into a HapticsStream, at the pace they were
+    /// captured at. Mixed by the HapticsHub like the stream of an effect instance, so the replay goes through the
+    /// same device path without any Godot bus.
+    class HapticsReplay {
+    public:
+        HapticsReplay() = default;
+        ~HapticsReplay();
+
+        HapticsReplay(const HapticsReplay&) = delete;
+        HapticsReplay& operator=(const HapticsReplay&) = delete;
+
+        /// Maps the capture and indexes the chunks of `source_controller`. Fails if the file isn't a capture or
+        /// holds no chunks of that controller.
+        bool open(const std::filesystem::path& path, int source_controller);
+
+        /// Starts feeding the stream once it is live.
+        void start();
+
+        [[nodiscard]] const std::shared_ptr<HapticsStream>& get_stream() const {
+            return m_stream;
+        }
+
+        [[nodiscard]] bool is_finished() const {
+            return m_finished.load();
+        }
+
+    private:
+        void run(const std::stop_token& stop_token);
+
+        MappedFileReader m_file;
+        // Offsets of the chunk headers of the replayed controller
+        std::vector<size_t> m_chunk_offsets;
+
+        std::shared_ptr<HapticsStream> m_stream;
+        HapticsStreamWriter m_writer;
+
+        std::jthread m_thread;
+        std::atomic<bool> m_finished = false;
+    };
+} // namespace hd_haptics
@@ -0,0 +1,97 @@
+#include "HapticsStats.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace hd_haptics {
+    void HapticsStats::record_callback(uint64_t duration_ns, uint32_t period_frames, uint32_t fill_level_frames, uint32_t latency_frames) {
+        m_callback_durations[get_bucket(duration_ns)].fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t max_ns = m_callback_max_ns.load(std::memory_order_relaxed);
+        while (duration_ns > max_ns && !m_callback_max_ns.compare_exchange_weak(max_ns, duration_ns, std::memory_order_relaxed)) {}
+
+        m_device_period_frames.store(period_frames, std::memory_order_relaxed);
+        m_fill_level_frames.store(fill_level_frames, std::memory_order_relaxed);
+        m_latency_frames.store(latency_frames, std::memory_order_relaxed);
+    }
+
+    HapticsStats::Snapshot HapticsStats::get_snapshot() const {
+        Snapshot snapshot;
+
+        std::array<uint64_t, HISTOGRAM_BUCKETS> counts{};
+        for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; ++bucket) {
+            counts[bucket] = m_callback_durations[bucket].load(std::memory_order_relaxed);
+            snapshot.callbacks += counts[bucket];
+        }
+
+        snapshot.callback_p50_ns = get_percentile(counts, snapshot.callbacks, 0.50);
+        snapshot.callback_p95_ns = get_percentile(counts, snapshot.callbacks, 0.95);
+        snapshot.callback_p99_ns = get_percentile(counts, snapshot.callbacks, 0.99);
+        snapshot.callback_max_ns = m_callback_max_ns.load(std::memory_order_relaxed);
+        snapshot.device_period_frames = m_device_period_frames.load(std::memory_order_relaxed);
+        snapshot.fill_level_frames = m_fill_level_frames.load(std::memory_order_relaxed);
+        snapshot.latency_frames = m_latency_frames.load(std::memory_order_relaxed);
+
+        snapshot.underruns = m_underruns.load(std::memory_order_relaxed);
+        snapshot.overruns = m_overruns.load(std::memory_order_relaxed);
+        snapshot.dropped_frames = m_dropped_frames.load(std::memory_order_relaxed);
+        snapshot.skipped_silent_frames = m_skipped_silent_frames.load(std::memory_order_relaxed);
+        snapshot.devices_connected = m_devices_connected.load(std::memory_order_relaxed);
+        snapshot.devices_disconnected = m_devices_disconnected.load(std::memory_order_relaxed);
+
+        return snapshot;
+    }
+
+    void HapticsStats::reset() {
+        for (auto& count : m_callback_durations) {
+            count.store(0, std::memory_order_relaxed);
+        }
+
+        m_callback_max_ns.store(0, std::memory_order_relaxed);
+        m_underruns.store(0, std::memory_order_relaxed);
+        m_overruns.store(0, std::memory_order_relaxed);
+        m_dropped_frames.store(0, std::memory_order_relaxed);
+        m_skipped_silent_frames.store(0, std::memory_order_relaxed);
+    }
+
+    int HapticsStats::get_bucket(uint64_t duration_ns) {
+        // Durations below 4 ns get a bucket each, above that every octave is split into four
+        if (duration_ns < 4) {
+            return static_cast<int>(duration_ns);
+        }
+
+        const int octave = std::bit_width(duration_ns) - 1;
+        const auto quarter = static_cast<int>((duration_ns >> (octave - 2)) & 3);
+
+        return std::min((octave - 1) * 4 + quarter, HISTOGRAM_BUCKETS - 1);
+    }
+
+    uint64_t HapticsStats::get_bucket_upper_bound(int bucket) {
+        if (bucket < 4) {
+            return static_cast<uint64_t>(bucket);
+        }
+
+        const int octave = bucket / 4 + 1;
+        const int quarter = bucket % 4;
+
+        return ((static_cast<uint64_t>(4 + quarter + 1)) << (octave - 2)) - 1;
+    }
+
+    uint64_t HapticsStats::get_percentile(const std::array<uint64_t, HISTOGRAM_BUCKETS>& counts, uint64_t total, double percentile) const {
+        if (total == 0) {
+            return 0;
+        }
+
+        const auto rank = static_cast<uint64_t>(static_cast<double>(total - 1) * percentile) + 1;
+        uint64_t seen = 0;
+
+        for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; ++bucket) {
+            seen += counts[bucket];
+            if (seen >= rank) {
+                return std::min(get_bucket_upper_bound(bucket), m_callback_max_ns.load(std::memory_order_relaxed));
+            }
+        }
+
+        return m_callback_max_ns.load(std::memory_order_relaxed);
+    }
+} // namespace hd_haptics
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace hd_haptics {
+    /// Runtime telemetry of one HapticsStream. Recording is lock-free and wait-free apart from the running
+    /// maximum, so it can be done from `_process` and the device callbacks. Any thread may read a snapshot.
+    class HapticsStats {
+    public:
+        struct Snapshot {
+            uint64_t callbacks = 0;
+            uint64_t callback_p50_ns = 0;
+            uint64_t callback_p95_ns = 0;
+            uint64_t callback_p99_ns = 0;
+            uint64_t callback_max_ns = 0;
+            uint32_t device_period_frames = 0;
+            uint32_t fill_level_frames = 0;
+            uint32_t latency_frames = 0;
+
+            uint64_t underruns = 0;
+            uint64_t overruns = 0;
+            uint64_t dropped_frames = 0;
+            uint64_t skipped_silent_frames = 0;
+            uint64_t devices_connected = 0;
+            uint64_t devices_disconnected = 0;
+        };
+
+        /// Records one device callback. `latency_frames` is the ring buffer fill level plus the device buffer,
+        /// i.e. how long a frame written by `_process` right now takes to reach the controller.
+        void record_callback(uint64_t duration_ns, uint32_t period_frames, uint32_t fill_level_frames, uint32_t latency_frames);
+
+        void add_underruns(uint32_t count) {
+            m_underruns.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        void add_overruns(uint32_t count) {
+            m_overruns.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        void add_dropped_frames(uint64_t frame_count) {
+            m_dropped_frames.fetch_add(frame_count, std::memory_order_relaxed);
+        }
+
+        void add_skipped_silent_frames(uint64_t frame_count) {
+            m_skipped_silent_frames.fetch_add(frame_count, std::memory_order_relaxed);
+        }
+
+        void record_device_connected() {
+            m_devices_connected.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void record_device_disconnected() {
+            m_devices_disconnected.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] uint64_t get_dropped_frames() const {
+            return m_dropped_frames.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] Snapshot get_snapshot() const;
+
+        /// Clears the callback duration histogram and the event counters. Concurrent recording may be lost.
+        void reset();
+
+    private:
+        // Callback durations are binned in quarter octaves of nanoseconds, covering up to ~8 seconds
+        static constexpr int HISTOGRAM_BUCKETS = 128;
+
+        static int get_bucket(uint64_t duration_ns);
+        static uint64_t get_bucket_upper_bound(int bucket);
+
+        [[nodiscard]] uint64_t get_percentile(const std::array<uint64_t, HISTOGRAM_BUCKETS>& counts, uint64_t total, double percentile) const;
+
+        std::array<std::atomic<uint64_t>, HISTOGRAM_BUCKETS> m_callback_durations{};
+        std::atomic<uint64_t> m_callback_max_ns = 0;
+        std::atomic<uint32_t> m_device_period_frames = 0;
+        std::atomic<uint32_t> m_fill_level_frames = 0;
+        std::atomic<uint32_t> m_latency_frames = 0;
+
+        std::atomic<uint64_t> m_underruns = 0;
+        std::atomic<uint64_t> m_overruns = 0;
+        std::atomic<uint64_t> m_dropped_frames = 0;
+        std::atomic<uint64_t> m_skipped_silent_frames = 0;
+        std::atomic<uint64_t> m_devices_connected = 0;
+        std::atomic<uint64_t> m_devices_disconnected = 0;
+    };
+} // namespace hd_haptics
@@ -0,0 +1,40 @@
+#include "HapticsStream.h"
+
+namespace hd_haptics {
+    // Largest block written at once. Covers a Godot mix block and a device period, and keeps room for the
+    // overflow policy to bring the fill level back down from twice the target latency.
+    constexpr uint32_t RING_BUFFER_BLOCK_FRAMES = 4096;
+
+    HapticsStream::HapticsStream(const Config& config) :
+        m_config(config) {
+        m_ring_buffer.initialize(config.target_frames * 2 + RING_BUFFER_BLOCK_FRAMES, RING_BUFFER_BLOCK_FRAMES);
+        m_last_activity.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    }
+
+    void HapticsStream::mark_active() {
+        m_last_activity.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+
+        // Only the first call after suspending wakes anyone up, so the audio thread doesn't keep signaling
+        if (m_suspended.load(std::memory_order_relaxed) && !m_wake_requested.exchange(true) && m_wake_handler) {
+            m_wake_handler();
+        }
+    }
+
+    std::chrono::steady_clock::duration HapticsStream::get_idle_time() const {
+        const std::chrono::steady_clock::time_point last_activity{std::chrono::steady_clock::duration(m_last_activity.load(std::memory_order_relaxed))};
+        return std::chrono::steady_clock::now() - last_activity;
+    }
+
+    bool HapticsStream::is_idle() const {
+        const std::chrono::milliseconds idle_timeout(m_idle_timeout.load(std::memory_order_relaxed));
+        return idle_timeout.count() > 0 && get_idle_time() > idle_timeout;
+    }
+
+    void HapticsStream::set_suspended(bool suspended) {
+        m_suspended.store(suspended);
+
+        if (!suspended) {
+            m_wake_requested.store(false);
+        }
+    }
+} // namespace hd_haptics
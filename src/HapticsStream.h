@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+#include "BroadcastRingBuffer.h"
+#include "HapticsStats.h"
+#include "HapticsVoicePool.h"
+#include "PolyphaseResampler.h"
+
+namespace hd_haptics {
+    /// The audio captured by one effect instance, shared by every device it is routed to. `_process` writes
+    /// each block once, and every device reads it through its own BroadcastRingBuffer::Reader and mixes it
+    /// with the streams of the other instances.
+    class HapticsStream {
+    public:
+        struct Config {
+            uint32_t sample_rate = 0;
+            uint32_t target_frames = 0;
+            bool time_stretch = false;
+            PolyphaseResampler::Quality resampler_quality = PolyphaseResampler::Quality::Standard;
+        };
+
+        explicit HapticsStream(const Config& config);
+
+        [[nodiscard]] const Config& get_config() const {
+            return m_config;
+        }
+
+        [[nodiscard]] const BroadcastRingBuffer& get_ring_buffer() const {
+            return m_ring_buffer;
+        }
+
+        [[nodiscard]] const HapticsClipQueue& get_clip_queue() const {
+            return m_clip_queue;
+        }
+
+        /// Not thread-safe, callers must serialize pushing clip commands.
+        void push_clip_command(const HapticsClipQueue::Command& command) {
+            m_clip_queue.push(command);
+        }
+
+        void write(const float* p_frames, uint32_t frame_count) {
+            m_ring_buffer.write(p_frames, frame_count);
+        }
+
+        /// Bit `n` routes the stream to the controller with index `n`.
+        void set_controller_mask(uint32_t controller_mask) {
+            m_controller_mask.store(controller_mask, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] bool is_routed_to(int controller_index) const {
+            return controller_index >= 0 && controller_index < 32 && (m_controller_mask.load(std::memory_order_relaxed) & (1u << controller_index)) != 0;
+        }
+
+        void set_channel_gains(float left_gain, float right_gain) {
+            m_left_gain.store(left_gain, std::memory_order_relaxed);
+            m_right_gain.store(right_gain, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] std::array<float, BroadcastRingBuffer::CHANNELS> get_channel_gains() const {
+            return {m_left_gain.load(std::memory_order_relaxed), m_right_gain.load(std::memory_order_relaxed)};
+        }
+
+        /// While any stream with a higher priority is audible, this one is attenuated by `ducking_gain`.
+        void set_mix_priority(int priority, float ducking_gain) {
+            m_priority.store(priority, std::memory_order_relaxed);
+            m_ducking_gain.store(ducking_gain, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] int get_priority() const {
+            return m_priority.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] float get_ducking_gain() const {
+            return m_ducking_gain.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] HapticsStats& get_stats() {
+            return m_stats;
+        }
+
+        [[nodiscard]] const HapticsStats& get_stats() const {
+            return m_stats;
+        }
+
+        /// Set while at least one device reads the stream.
+        void set_live(bool live) {
+            m_live.store(live, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] bool is_live() const {
+            return m_live.load(std::memory_order_relaxed);
+        }
+
+        /// Set while `_process` holds back silence. Devices running dry meanwhile is expected, not an underrun.
+        void set_gated(bool gated) {
+            m_gated.store(gated, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] bool is_gated() const {
+            return m_gated.load(std::memory_order_relaxed);
+        }
+
+        /// Called by mark_active() on the first activity after suspending. Must be set before the stream is live.
+        void set_wake_handler(std::function<void()> wake_handler) {
+            m_wake_handler = std::move(wake_handler);
+        }
+
+        /// Records that audible content was just written or played. If the devices are suspended, this calls
+        /// the wake handler so they can be resumed.
+        void mark_active();
+
+        [[nodiscard]] std::chrono::steady_clock::duration get_idle_time() const;
+
+        /// 0 keeps the devices running while the stream is idle.
+        void set_idle_timeout(std::chrono::milliseconds idle_timeout) {
+            m_idle_timeout.store(idle_timeout.count(), std::memory_order_relaxed);
+        }
+
+        /// Whether the stream has been idle for longer than its idle timeout.
+        [[nodiscard]] bool is_idle() const;
+
+        void set_suspended(bool suspended);
+
+        [[nodiscard]] bool is_suspended() const {
+            return m_suspended.load(std::memory_order_relaxed);
+        }
+
+    private:
+        Config m_config;
+        BroadcastRingBuffer m_ring_buffer;
+        HapticsClipQueue m_clip_queue;
+        std::atomic<uint32_t> m_controller_mask = ~0u;
+        std::atomic<float> m_left_gain = 1.0f;
+        std::atomic<float> m_right_gain = 1.0f;
+        std::atomic<int> m_priority = 0;
+        std::atomic<float> m_ducking_gain = 1.0f;
+        HapticsStats m_stats;
+        std::atomic<bool> m_live = false;
+        std::atomic<bool> m_gated = false;
+
+        std::atomic<std::chrono::steady_clock::rep> m_last_activity;
+        std::atomic<std::chrono::milliseconds::rep> m_idle_timeout = 0;
+        std::atomic<bool> m_suspended = false;
+        std::atomic<bool> m_wake_requested = false;
+        std::function<void()> m_wake_handler;
+    };
+} // namespace hd_haptics
@@ -0,0 +1,53 @@
+#include "HapticsStreamWriter.h"
+
+#include <algorithm>
+
+#include "SilenceDetection.h"
+
+namespace hd_haptics {
+    constexpr uint32_t CONDITIONER_CHUNK_FRAMES = 1024;
+
+    void HapticsStreamWriter::initialize(std::shared_ptr<HapticsStream> stream) {
+        m_stream = std::move(stream);
+        m_conditioner.set_sample_rate(m_stream->get_config().sample_rate);
+        m_conditioner_buffer.resize(static_cast<size_t>(CONDITIONER_CHUNK_FRAMES) * HapticsConditioner::CHANNELS);
+        m_silent_frames = 0;
+    }
+
+    void HapticsStreamWriter::write(const float* p_frames, uint32_t frame_count) {
+        if (!m_conditioner.is_enabled()) {
+            write_gated(p_frames, frame_count);
+            return;
+        }
+
+        for (uint32_t offset = 0; offset < frame_count; offset += CONDITIONER_CHUNK_FRAMES) {
+            const uint32_t chunk_frames = std::min(frame_count - offset, CONDITIONER_CHUNK_FRAMES);
+            const float* p_chunk = p_frames + static_cast<size_t>(offset) * HapticsConditioner::CHANNELS;
+
+            std::copy_n(p_chunk, static_cast<size_t>(chunk_frames) * HapticsConditioner::CHANNELS, m_conditioner_buffer.data());
+            m_conditioner.process(m_conditioner_buffer.data(), chunk_frames);
+            write_gated(m_conditioner_buffer.data(), chunk_frames);
+        }
+    }
+
+    void HapticsStreamWriter::write_gated(const float* p_frames, uint32_t frame_count) {
+        if (!is_silent(p_frames, static_cast<size_t>(frame_count) * BroadcastRingBuffer::CHANNELS)) {
+            m_silent_frames = 0;
+            m_stream->set_gated(false);
+            m_stream->mark_active();
+            m_stream->write(p_frames, frame_count);
+            return;
+        }
+
+        // Short pauses are written as they are, so the timing of what follows is kept. Once the silence outlasts
+        // the target latency, writing stops and the devices drain the ring buffer and run dry.
+        if (m_silent_frames < m_stream->get_config().target_frames) {
+            m_stream->write(p_frames, frame_count);
+        } else {
+            m_stream->set_gated(true);
+            m_stream->get_stats().add_skipped_silent_frames(frame_count);
+        }
+
+        m_silent_frames = std::min<uint64_t>(m_silent_frames + frame_count, UINT32_MAX);
+    }
+} // namespace hd_haptics
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "HapticsConditioner.h"
+#include "HapticsStream.h"
+
+namespace hd_haptics {
+    /// The producer side of a HapticsStream: conditions the bus audio, holds back longer silences and writes
+    /// the rest to the ring buffer. `_process` hands every mix block to write().
+    ///
+    /// Doesn't depend on Godot, so anything that calls write() at the mix rate can stand in for the audio server.
+    class HapticsStreamWriter {
+    public:
+        void initialize(std::shared_ptr<HapticsStream> stream);
+
+        void set_conditioner_settings(const HapticsConditioner::Settings& settings) {
+            m_conditioner.set_settings(settings);
+        }
+
+        /// Writes `frame_count` interleaved stereo frames.
+        void write(const float* p_frames, uint32_t frame_count);
+
+    private:
+        /// Writes a block to the stream, skipping it if it is part of a longer silence.
+        void write_gated(const float* p_frames, uint32_t frame_count);
+
+        std::shared_ptr<HapticsStream> m_stream;
+
+        // Bus audio is copied into the scratch buffer in chunks to be conditioned, since the source is read-only
+        HapticsConditioner m_conditioner;
+        std::vector<float> m_conditioner_buffer;
+
+        // Frames of silence written since the last audible block
+        uint64_t m_silent_frames = 0;
+    };
+} // namespace hd_haptics
@@ -0,0 +1,108 @@
+#include "HapticsVoicePool.h"
+
+#include <algorithm>
+
+namespace hd_haptics {
+    void HapticsClipQueue::push(const Command& command) {
+        const uint64_t write_position = m_write_position.load(std::memory_order_relaxed);
+        m_commands[write_position % CAPACITY] = command;
+        m_write_position.store(write_position + 1, std::memory_order_release);
+    }
+
+    void HapticsVoicePool::attach(const HapticsClipQueue& queue, double step) {
+        m_queue = &queue;
+        m_step = step;
+        m_read_position = queue.m_write_position.load(std::memory_order_acquire);
+    }
+
+    void HapticsVoicePool::poll(int controller_index) {
+        const uint64_t write_position = m_queue->m_write_position.load(std::memory_order_acquire);
+        m_read_position = std::max(m_read_position, write_position - std::min<uint64_t>(write_position, HapticsClipQueue::READABLE_COMMANDS));
+
+        for (; m_read_position < write_position; ++m_read_position) {
+            const HapticsClipQueue::Command& command = m_queue->m_commands[m_read_position % HapticsClipQueue::CAPACITY];
+
+            if (command.clip == nullptr) {
+                m_voices.fill({});
+                m_active_voices = 0;
+            } else if (controller_index >= 0 && controller_index < 32 && (command.controller_mask & (1u << controller_index)) != 0) {
+                start(command);
+            }
+        }
+    }
+
+    void HapticsVoicePool::start(const HapticsClipQueue::Command& command) {
+        // Take a free voice, or steal the one closest to its end when all are busy
+        Voice* voice = std::ranges::min_element(m_voices, [](const Voice& a, const Voice& b) {
+            const uint32_t remaining_a = a.clip != nullptr ? a.clip->get_frame_count() - a.position : 0;
+            const uint32_t remaining_b = b.clip != nullptr ? b.clip->get_frame_count() - b.position : 0;
+            return remaining_a < remaining_b;
+        });
+
+        if (voice->clip == nullptr) {
+            ++m_active_voices;
+        }
+
+        voice->clip = command.clip;
+        voice->position = 0;
+        voice->fraction = 0.0;
+        voice->gains = command.gains;
+    }
+
+    void HapticsVoicePool::mix(float* p_frames, uint32_t frame_count) {
+        if (m_active_voices == 0) {
+            return;
+        }
+
+        for (Voice& voice : m_voices) {
+            if (voice.clip == nullptr) {
+                continue;
+            }
+
+            if (m_step != 1.0) {
+                mix_resampled(voice, p_frames, frame_count);
+            } else {
+                const uint32_t mix_frames = std::min(frame_count, voice.clip->get_frame_count() - voice.position);
+                const float* p_clip_frames = voice.clip->get_frames() + static_cast<size_t>(voice.position) * HapticsClip::CHANNELS;
+                const float left_gain = voice.gains[0];
+                const float right_gain = voice.gains[1];
+
+                for (uint32_t frame = 0; frame < mix_frames; ++frame) {
+                    p_frames[frame * 2] += p_clip_frames[frame * 2] * left_gain;
+                    p_frames[frame * 2 + 1] += p_clip_frames[frame * 2 + 1] * right_gain;
+                }
+
+                voice.position += mix_frames;
+            }
+
+            if (voice.position >= voice.clip->get_frame_count()) {
+                voice = {};
+                --m_active_voices;
+            }
+        }
+    }
+
+    void HapticsVoicePool::mix_resampled(Voice& voice, float* p_frames, uint32_t frame_count) const {
+        // Linear interpolation is enough here, haptic clips are far below the Nyquist frequency of either rate
+        const uint32_t clip_frame_count = voice.clip->get_frame_count();
+        const float* p_clip_frames = voice.clip->get_frames();
+        const float left_gain = voice.gains[0];
+        const float right_gain = voice.gains[1];
+
+        for (uint32_t frame = 0; frame < frame_count && voice.position < clip_frame_count; ++frame) {
+            const float* p_current = p_clip_frames + static_cast<size_t>(voice.position) * HapticsClip::CHANNELS;
+            // The clip fades to silence after its last frame
+            const float next_left = voice.position + 1 < clip_frame_count ? p_current[2] : 0.0f;
+            const float next_right = voice.position + 1 < clip_frame_count ? p_current[3] : 0.0f;
+            const auto t = static_cast<float>(voice.fraction);
+
+            p_frames[frame * 2] += (p_current[0] + (next_left - p_current[0]) * t) * left_gain;
+            p_frames[frame * 2 + 1] += (p_current[1] + (next_right - p_current[1]) * t) * right_gain;
+
+            voice.fraction += m_step;
+            const auto whole_frames = static_cast<uint32_t>(voice.fraction);
+            voice.position += whole_frames;
+            voice.fraction -= whole_frames;
+        }
+    }
+} // namespace hd_haptics
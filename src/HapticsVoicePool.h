@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "HapticsClip.h"
+
+namespace hd_haptics {
+    /// Requests to start or stop clips, broadcast to every device of a stream. The producer side is called from
+    /// script and must be serialized by the caller; every device polls the queue at the start of its callback
+    /// through its own HapticsVoicePool. Commands are fixed size and never allocate.
+    class HapticsClipQueue {
+    public:
+        struct Command {
+            // Null stops every voice
+            const HapticsClip* clip = nullptr;
+            std::array<float, HapticsClip::CHANNELS> gains{};
+            uint32_t controller_mask = 0;
+        };
+
+        static constexpr uint32_t CAPACITY = 64;
+        // Devices lagging behind more than this skip the older commands, which keeps them clear of the slots being written
+        static constexpr uint32_t READABLE_COMMANDS = CAPACITY / 2;
+
+        void push(const Command& command);
+
+    private:
+        friend class HapticsVoicePool;
+
+        std::array<Command, CAPACITY> m_commands{};
+        std::atomic<uint64_t> m_write_position = 0;
+    };
+
+    /// Fixed set of voices playing clips, mixed into the stereo output of one device.
+    class HapticsVoicePool {
+    public:
+        static constexpr int MAX_VOICES = 32;
+
+        /// Starts reading commands pushed from now on. `step` is the number of clip frames per output frame, the
+        /// ratio of the stream rate the clips were decoded at to the device rate.
+        void attach(const HapticsClipQueue& queue, double step);
+
+        /// Applies the commands pushed since the last call that target `controller_index`.
+        void poll(int controller_index);
+
+        /// Adds the playing voices to `frame_count` interleaved stereo frames.
+        void mix(float* p_frames, uint32_t frame_count);
+
+        [[nodiscard]] bool is_playing() const {
+            return m_active_voices > 0;
+        }
+
+    private:
+        struct Voice {
+            const HapticsClip* clip = nullptr;
+            uint32_t position = 0;
+            // Position between `position` and the next frame while the rates differ
+            double fraction = 0.0;
+            std::array<float, HapticsClip::CHANNELS> gains{};
+        };
+
+        void start(const HapticsClipQueue::Command& command);
+        void mix_resampled(Voice& voice, float* p_frames, uint32_t frame_count) const;
+
+        const HapticsClipQueue* m_queue = nullptr;
+        double m_step = 1.0;
+        uint64_t m_read_position = 0;
+
+        std::array<Voice, MAX_VOICES> m_voices{};
+        int m_active_voices = 0;
+    };
+} // namespace hd_haptics
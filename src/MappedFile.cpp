@@ -0,0 +1,277 @@
+#include "MappedFile.h"
+
+#include <algorithm>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace hd_haptics {
+    // The mapping grows in steps of at least this size, so remapping stays rare
+    constexpr size_t GROWTH_BYTES = 8 * 1024 * 1024;
+
+    MappedFileWriter::~MappedFileWriter() {
+        close();
+    }
+
+#if defined(_WIN32)
+    bool MappedFileWriter::open(const std::filesystem::path& path) {
+        close();
+
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        m_file = file;
+        m_size = 0;
+        m_is_open = map(GROWTH_BYTES);
+
+        if (!m_is_open) {
+            CloseHandle(static_cast<HANDLE>(m_file));
+            m_file = nullptr;
+        }
+
+        return m_is_open;
+    }
+
+    bool MappedFileWriter::map(size_t capacity) {
+        LARGE_INTEGER file_size;
+        file_size.QuadPart = static_cast<LONGLONG>(capacity);
+
+        // Creating a mapping larger than the file grows the file
+        HANDLE mapping = CreateFileMappingW(static_cast<HANDLE>(m_file), nullptr, PAGE_READWRITE, file_size.HighPart, file_size.LowPart, nullptr);
+        if (mapping == nullptr) {
+            return false;
+        }
+
+        void* data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, capacity);
+        if (data == nullptr) {
+            CloseHandle(mapping);
+            return false;
+        }
+
+        m_mapping = mapping;
+        m_data = static_cast<uint8_t*>(data);
+        m_capacity = capacity;
+
+        return true;
+    }
+
+    void MappedFileWriter::unmap() {
+        if (m_data != nullptr) {
+            UnmapViewOfFile(m_data);
+            m_data = nullptr;
+        }
+
+        if (m_mapping != nullptr) {
+            CloseHandle(static_cast<HANDLE>(m_mapping));
+            m_mapping = nullptr;
+        }
+
+        m_capacity = 0;
+    }
+
+    void MappedFileWriter::close() {
+        if (!m_is_open) {
+            return;
+        }
+
+        unmap();
+
+        LARGE_INTEGER size;
+        size.QuadPart = static_cast<LONGLONG>(m_size);
+        SetFilePointerEx(static_cast<HANDLE>(m_file), size, nullptr, FILE_BEGIN);
+        SetEndOfFile(static_cast<HANDLE>(m_file));
+
+        CloseHandle(static_cast<HANDLE>(m_file));
+        m_file = nullptr;
+        m_is_open = false;
+    }
+#else
+    bool MappedFileWriter::open(const std::filesystem::path& path) {
+        close();
+
+        m_file = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (m_file < 0) {
+            return false;
+        }
+
+        m_size = 0;
+        m_is_open = map(GROWTH_BYTES);
+
+        if (!m_is_open) {
+            ::close(m_file);
+            m_file = -1;
+        }
+
+        return m_is_open;
+    }
+
+    bool MappedFileWriter::map(size_t capacity) {
+        if (ftruncate(m_file, static_cast<off_t>(capacity)) != 0) {
+            return false;
+        }
+
+        void* data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+        if (data == MAP_FAILED) {
+            return false;
+        }
+
+        m_data = static_cast<uint8_t*>(data);
+        m_capacity = capacity;
+
+        return true;
+    }
+
+    void MappedFileWriter::unmap() {
+        if (m_data != nullptr) {
+            munmap(m_data, m_capacity);
+            m_data = nullptr;
+        }
+
+        m_capacity = 0;
+    }
+
+    void MappedFileWriter::close() {
+        if (!m_is_open) {
+            return;
+        }
+
+        unmap();
+
+        // Drop the unused tail of the last growth step
+        [[maybe_unused]] const int result = ftruncate(m_file, static_cast<off_t>(m_size));
+
+        ::close(m_file);
+        m_file = -1;
+        m_is_open = false;
+    }
+#endif
+
+    uint8_t* MappedFileWriter::append(size_t size) {
+        if (!m_is_open) {
+            return nullptr;
+        }
+
+        if (m_size + size > m_capacity) {
+            const size_t capacity = std::max(m_capacity * 2, m_size + size + GROWTH_BYTES);
+
+            unmap();
+            if (!map(capacity)) {
+                close();
+                return nullptr;
+            }
+        }
+
+        uint8_t* p_data = m_data + m_size;
+        m_size += size;
+
+        return p_data;
+    }
+
+    MappedFileReader::~MappedFileReader() {
+        close();
+    }
+
+#if defined(_WIN32)
+    bool MappedFileReader::open(const std::filesystem::path& path) {
+        close();
+
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        m_file = file;
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+            close();
+            return false;
+        }
+
+        m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping == nullptr) {
+            close();
+            return false;
+        }
+
+        m_data = static_cast<const uint8_t*>(MapViewOfFile(static_cast<HANDLE>(m_mapping), FILE_MAP_READ, 0, 0, 0));
+        if (m_data == nullptr) {
+            close();
+            return false;
+        }
+
+        m_size = static_cast<size_t>(file_size.QuadPart);
+
+        return true;
+    }
+
+    void MappedFileReader::close() {
+        if (m_data != nullptr) {
+            UnmapViewOfFile(m_data);
+            m_data = nullptr;
+        }
+
+        if (m_mapping != nullptr) {
+            CloseHandle(static_cast<HANDLE>(m_mapping));
+            m_mapping = nullptr;
+        }
+
+        if (m_file != nullptr) {
+            CloseHandle(static_cast<HANDLE>(m_file));
+            m_file = nullptr;
+        }
+
+        m_size = 0;
+    }
+#else
+    bool MappedFileReader::open(const std::filesystem::path& path) {
+        close();
+
+        m_file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (m_file < 0) {
+            return false;
+        }
+
+        struct stat file_status {};
+        if (fstat(m_file, &file_status) != 0 || file_status.st_size == 0) {
+            close();
+            return false;
+        }
+
+        void* data = mmap(nullptr, static_cast<size_t>(file_status.st_size), PROT_READ, MAP_PRIVATE, m_file, 0);
+        if (data == MAP_FAILED) {
+            close();
+            return false;
+        }
+
+        m_data = static_cast<const uint8_t*>(data);
+        m_size = static_cast<size_t>(file_status.st_size);
+
+        return true;
+    }
+
+    void MappedFileReader::close() {
+        if (m_data != nullptr) {
+            munmap(const_cast<uint8_t*>(m_data), m_size);
+            m_data = nullptr;
+        }
+
+        if (m_file >= 0) {
+            ::close(m_file);
+            m_file = -1;
+        }
+
+        m_size = 0;
+    }
+#endif
+} // namespace hd_haptics
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace hd_haptics {
+    /// A file written through a memory mapping that grows as data is appended. Appending is a plain memory
+    /// copy, the operating system writes the pages back in the background. Not thread-safe.
+    class MappedFileWriter {
+    public:
+        MappedFileWriter() = default;
+        ~MappedFileWriter();
+
+        MappedFileWriter(const MappedFileWriter&) = delete;
+        MappedFileWriter& operator=(const MappedFileWriter&) = delete;
+
+        /// Creates or truncates the file.
+        bool open(const std::filesystem::path& path);
+
+        /// Returns `size` writable bytes at the end of the file, or null if the file couldn't grow. The pointer
+        /// is valid until the next call.
+        uint8_t* append(size_t size);
+
+        /// Unmaps the file and truncates it to the bytes appended.
+        void close();
+
+        [[nodiscard]] bool is_open() const {
+            return m_is_open;
+        }
+
+    private:
+        bool map(size_t capacity);
+        void unmap();
+
+        bool m_is_open = false;
+        uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+        size_t m_capacity = 0;
+
+#if defined(_WIN32)
+        void* m_file = nullptr;
+        void* m_mapping = nullptr;
+#else
+        int m_file = -1;
+#endif
+    };
+
+    /// A file mapped read-only in its entirety.
+    class MappedFileReader {
+    public:
+        MappedFileReader() = default;
+        ~MappedFileReader();
+
+        MappedFileReader(const MappedFileReader&) = delete;
+        MappedFileReader& operator=(const MappedFileReader&) = delete;
+
+        bool open(const std::filesystem::path& path);
+        void close();
+
+        [[nodiscard]] const uint8_t* get_data() const {
+            return m_data;
+        }
+
+        [[nodiscard]] size_t get_size() const {
+            return m_size;
+        }
+
+    private:
+        const uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+
+#if defined(_WIN32)
+        void* m_file = nullptr;
+        void* m_mapping = nullptr;
+#else
+        int m_file = -1;
+#endif
+    };
+} // namespace hd_haptics
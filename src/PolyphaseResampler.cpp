@@ -0,0 +1,177 @@
+#include "PolyphaseResampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#include "Simd.h"
+
+namespace hd_haptics {
+    struct FilterDesign {
+        int taps;
+        // Kaiser window shape, higher trades a wider transition band for more stopband attenuation
+        double beta;
+        // Cutoff relative to the lower Nyquist frequency of the two rates
+        double cutoff;
+    };
+
+    static FilterDesign get_filter_design(PolyphaseResampler::Quality quality) {
+        switch (quality) {
+            case PolyphaseResampler::Quality::Linear:
+                return {2, 0.0, 1.0};
+            case PolyphaseResampler::Quality::Standard:
+                return {16, 6.0, 0.85};
+            case PolyphaseResampler::Quality::High:
+            default:
+                return {PolyphaseResampler::MAX_TAPS, 9.0, 0.9};
+        }
+    }
+
+    // Zeroth order modified Bessel function of the first kind, for the Kaiser window
+    static double bessel_i0(double x) {
+        double sum = 1.0;
+        double term = 1.0;
+
+        for (int k = 1; k < 32; ++k) {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    void PolyphaseResampler::initialize(Quality quality, uint32_t input_rate, uint32_t output_rate) {
+        const FilterDesign design = get_filter_design(quality);
+        m_taps = design.taps;
+        m_coefficients.assign(static_cast<size_t>(PHASES + 1) * m_taps, 0.0f);
+
+        // Downsampling must also remove what lies above the output Nyquist frequency
+        const double cutoff = design.cutoff * std::min(1.0, static_cast<double>(output_rate) / std::max<uint32_t>(input_rate, 1));
+        const double half_width = m_taps / 2.0;
+
+        for (int phase = 0; phase <= PHASES; ++phase) {
+            const double t = static_cast<double>(phase) / PHASES;
+            float* p_row = m_coefficients.data() + static_cast<size_t>(phase) * m_taps;
+            double sum = 0.0;
+
+            for (int tap = 0; tap < m_taps; ++tap) {
+                // Distance of the tap from the interpolated position, which lies `t` past tap m_taps / 2 - 1
+                const double distance = tap - (half_width - 1.0) - t;
+                double coefficient;
+
+                if (quality == Quality::Linear) {
+                    coefficient = std::max(0.0, 1.0 - std::abs(distance));
+                } else {
+                    const double x = std::numbers::pi * cutoff * distance;
+                    const double sinc = std::abs(x) < 1e-9 ? 1.0 : std::sin(x) / x;
+                    const double window_position = std::clamp(distance / half_width, -1.0, 1.0);
+                    coefficient = sinc * bessel_i0(design.beta * std::sqrt(1.0 - window_position * window_position)) / bessel_i0(design.beta);
+                }
+
+                p_row[tap] = static_cast<float>(coefficient);
+                sum += coefficient;
+            }
+
+            // Unity gain at DC for every phase, otherwise the phase modulates the signal
+            for (int tap = 0; tap < m_taps; ++tap) {
+                p_row[tap] = static_cast<float>(p_row[tap] / sum);
+            }
+        }
+
+        reset();
+    }
+
+    void PolyphaseResampler::reset() {
+        for (auto& history : m_history) {
+            history.fill(0.0f);
+        }
+
+        m_history_position = 0;
+    }
+
+    void PolyphaseResampler::interpolate(float phase, float* p_output) const {
+        // Blend the two closest phases of the table
+        const float table_position = std::clamp(phase, 0.0f, 1.0f) * PHASES;
+        const int row = std::min(static_cast<int>(table_position), PHASES - 1);
+        const float blend = table_position - static_cast<float>(row);
+
+        const float* p_coefficients_a = m_coefficients.data() + static_cast<size_t>(row) * m_taps;
+        const float* p_coefficients_b = p_coefficients_a + m_taps;
+        const float* p_left = m_history[0].data() + m_history_position;
+        const float* p_right = m_history[1].data() + m_history_position;
+
+        float left = 0.0f;
+        float right = 0.0f;
+        int tap = 0;
+
+#if defined(HD_HAPTICS_SIMD_AVX)
+        const __m256 blend_vector = _mm256_set1_ps(blend);
+        __m256 left_sum = _mm256_setzero_ps();
+        __m256 right_sum = _mm256_setzero_ps();
+
+        for (; tap + 8 <= m_taps; tap += 8) {
+            const __m256 a = _mm256_loadu_ps(p_coefficients_a + tap);
+            const __m256 b = _mm256_loadu_ps(p_coefficients_b + tap);
+            const __m256 coefficients = _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), blend_vector));
+
+            left_sum = _mm256_add_ps(left_sum, _mm256_mul_ps(coefficients, _mm256_loadu_ps(p_left + tap)));
+            right_sum = _mm256_add_ps(right_sum, _mm256_mul_ps(coefficients, _mm256_loadu_ps(p_right + tap)));
+        }
+
+        // Reduce both sums at once: left in the low, right in the high half of each 128 bit lane
+        const __m256 pairs = _mm256_hadd_ps(left_sum, right_sum);
+        const __m128 halves = _mm_add_ps(_mm256_castps256_ps128(pairs), _mm256_extractf128_ps(pairs, 1));
+        const __m128 sums = _mm_hadd_ps(halves, halves);
+        left = _mm_cvtss_f32(sums);
+        right = _mm_cvtss_f32(_mm_shuffle_ps(sums, sums, 1));
+#elif defined(HD_HAPTICS_SIMD_SSE2)
+        const __m128 blend_vector = _mm_set1_ps(blend);
+        __m128 left_sum = _mm_setzero_ps();
+        __m128 right_sum = _mm_setzero_ps();
+
+        for (; tap + 4 <= m_taps; tap += 4) {
+            const __m128 a = _mm_loadu_ps(p_coefficients_a + tap);
+            const __m128 b = _mm_loadu_ps(p_coefficients_b + tap);
+            const __m128 coefficients = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), blend_vector));
+
+            left_sum = _mm_add_ps(left_sum, _mm_mul_ps(coefficients, _mm_loadu_ps(p_left + tap)));
+            right_sum = _mm_add_ps(right_sum, _mm_mul_ps(coefficients, _mm_loadu_ps(p_right + tap)));
+        }
+
+        // Transpose-add: (l0 + l2, r0 + r2, l1 + l3, r1 + r3), then fold the upper pair onto the lower one
+        const __m128 interleaved = _mm_add_ps(_mm_unpacklo_ps(left_sum, right_sum), _mm_unpackhi_ps(left_sum, right_sum));
+        const __m128 sums = _mm_add_ps(interleaved, _mm_movehl_ps(interleaved, interleaved));
+        left = _mm_cvtss_f32(sums);
+        right = _mm_cvtss_f32(_mm_shuffle_ps(sums, sums, 1));
+#elif defined(HD_HAPTICS_SIMD_NEON)
+        const float32x4_t blend_vector = vdupq_n_f32(blend);
+        float32x4_t left_sum = vdupq_n_f32(0.0f);
+        float32x4_t right_sum = vdupq_n_f32(0.0f);
+
+        for (; tap + 4 <= m_taps; tap += 4) {
+            const float32x4_t a = vld1q_f32(p_coefficients_a + tap);
+            const float32x4_t b = vld1q_f32(p_coefficients_b + tap);
+            const float32x4_t coefficients = vmlaq_f32(a, vsubq_f32(b, a), blend_vector);
+
+            left_sum = vmlaq_f32(left_sum, coefficients, vld1q_f32(p_left + tap));
+            right_sum = vmlaq_f32(right_sum, coefficients, vld1q_f32(p_right + tap));
+        }
+
+        const float32x2_t sums = vpadd_f32(
+            vadd_f32(vget_low_f32(left_sum), vget_high_f32(left_sum)), vadd_f32(vget_low_f32(right_sum), vget_high_f32(right_sum))
+        );
+        left = vget_lane_f32(sums, 0);
+        right = vget_lane_f32(sums, 1);
+#endif
+
+        // Tap counts that don't fill a vector, and targets without SIMD
+        for (; tap < m_taps; ++tap) {
+            const float coefficient = p_coefficients_a[tap] + (p_coefficients_b[tap] - p_coefficients_a[tap]) * blend;
+            left += coefficient * p_left[tap];
+            right += coefficient * p_right[tap];
+        }
+
+        p_output[0] = left;
+        p_output[1] = right;
+    }
+} // namespace hd_haptics
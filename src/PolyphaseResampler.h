@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace hd_haptics {
+    /// Band-limited interpolation of stereo frames at arbitrary fractional positions, using a windowed sinc
+    /// filter precomputed for a fixed set of phases. Frames are pushed one by one, and interpolate() returns
+    /// the frame at a position between the two center frames of the filter.
+    ///
+    /// Used by the DriftCompensator to convert from the Godot mix rate to the device rate in the same pass
+    /// that compensates the clock drift, so the device can run at its native rate.
+    class PolyphaseResampler {
+    public:
+        enum class Quality {
+            /// Two taps, the same linear interpolation miniaudio uses. Cheapest, but images above the input
+            /// Nyquist frequency pass through.
+            Linear,
+            /// 16 taps, enough for the low frequency content of haptics.
+            Standard,
+            /// 32 taps with a steeper cutoff, for full range audio routed to the actuators.
+            High,
+        };
+
+        static constexpr int CHANNELS = 2;
+        static constexpr int MAX_TAPS = 32;
+
+        /// Builds the coefficient table for reading `input_rate` frames at `output_rate`. Allocates, so call it
+        /// before the audio thread starts using the resampler.
+        void initialize(Quality quality, uint32_t input_rate, uint32_t output_rate);
+
+        /// Clears the frame history.
+        void reset();
+
+        /// Appends an interleaved stereo frame to the history.
+        void push(const float* p_frame) {
+            for (int channel = 0; channel < CHANNELS; ++channel) {
+                // Every frame is stored twice, so the last `m_taps` frames are always contiguous
+                m_history[channel][m_history_position] = p_frame[channel];
+                m_history[channel][m_history_position + m_taps] = p_frame[channel];
+            }
+
+            m_history_position = m_history_position + 1 == m_taps ? 0 : m_history_position + 1;
+        }
+
+        /// Writes the interleaved stereo frame at `phase` (in [0, 1)) between the two center frames of the history.
+        void interpolate(float phase, float* p_output) const;
+
+        /// Frames the center of the filter lags behind the newest frame pushed, on top of the interpolated phase.
+        [[nodiscard]] uint32_t get_latency_frames() const {
+            return static_cast<uint32_t>(m_taps / 2 - 1);
+        }
+
+    private:
+        static constexpr int PHASES = 256;
+
+        int m_taps = 2;
+        // PHASES + 1 rows of m_taps coefficients, the last row lets interpolate() blend past the final phase
+        std::vector<float> m_coefficients;
+
+        std::array<std::array<float, MAX_TAPS * 2>, CHANNELS> m_history{};
+        int m_history_position = 0;
+    };
+} // namespace hd_haptics
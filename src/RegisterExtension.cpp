@@ -8,6 +8,8 @@
 
 #include "AudioEffectControllerHaptics.h"
 #include "AudioEffectControllerHapticsInstance.h"
+#include "HapticsDeviceManager.h"
+#include "HapticsHub.h"
 #include "godot_cpp/classes/engine.hpp"
 
 /// @file
@@ -24,6 +26,9 @@ namespace {
             return;
         }
 
+        hd_haptics::HapticsDeviceManager::create_singleton();
+        hd_haptics::HapticsHub::create_singleton();
+
         godot::ClassDB::register_class<hd_haptics::AudioEffectControllerHaptics>();
         godot::ClassDB::register_class<hd_haptics::AudioEffectControllerHapticsInstance>();
     }
@@ -35,6 +40,9 @@ namespace {
         if (p_level != godot::MODULE_INITIALIZATION_LEVEL_SCENE) {
             return;
         }
+
+        hd_haptics::HapticsHub::destroy_singleton();
+        hd_haptics::HapticsDeviceManager::destroy_singleton();
     }
 } // namespace
 
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "Simd.h"
+
+namespace hd_haptics {
+    /// Samples at or below this level (-100 dB) are considered silent.
+    constexpr float SILENCE_THRESHOLD = 1e-5f;
+
+    /// Returns whether no sample in the block exceeds `threshold` in magnitude. The whole block is scanned
+    /// with a running maximum, so the cost doesn't depend on the content.
+    inline bool is_silent(const float* p_samples, size_t sample_count, float threshold = SILENCE_THRESHOLD) {
+        size_t sample = 0;
+        float peak = 0.0f;
+
+#if defined(HD_HAPTICS_SIMD_AVX)
+        const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+        __m256 peaks = _mm256_setzero_ps();
+
+        for (; sample + 8 <= sample_count; sample += 8) {
+            peaks = _mm256_max_ps(peaks, _mm256_and_ps(_mm256_loadu_ps(p_samples + sample), abs_mask));
+        }
+
+        __m128 half = _mm_max_ps(_mm256_castps256_ps128(peaks), _mm256_extractf128_ps(peaks, 1));
+        half = _mm_max_ps(half, _mm_movehl_ps(half, half));
+        half = _mm_max_ss(half, _mm_shuffle_ps(half, half, 1));
+        peak = _mm_cvtss_f32(half);
+#elif defined(HD_HAPTICS_SIMD_SSE2)
+        const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 peaks = _mm_setzero_ps();
+
+        for (; sample + 4 <= sample_count; sample += 4) {
+            peaks = _mm_max_ps(peaks, _mm_and_ps(_mm_loadu_ps(p_samples + sample), abs_mask));
+        }
+
+        peaks = _mm_max_ps(peaks, _mm_movehl_ps(peaks, peaks));
+        peaks = _mm_max_ss(peaks, _mm_shuffle_ps(peaks, peaks, 1));
+        peak = _mm_cvtss_f32(peaks);
+#elif defined(HD_HAPTICS_SIMD_NEON)
+        float32x4_t peaks = vdupq_n_f32(0.0f);
+
+        for (; sample + 4 <= sample_count; sample += 4) {
+            peaks = vmaxq_f32(peaks, vabsq_f32(vld1q_f32(p_samples + sample)));
+        }
+
+        const float32x2_t pair = vmax_f32(vget_low_f32(peaks), vget_high_f32(peaks));
+        peak = std::max(vget_lane_f32(pair, 0), vget_lane_f32(pair, 1));
+#endif
+
+        for (; sample < sample_count; ++sample) {
+            peak = std::max(peak, std::abs(p_samples[sample]));
+        }
+
+        return peak <= threshold;
+    }
+} // namespace hd_haptics
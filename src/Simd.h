@@ -0,0 +1,14 @@
+#pragma once
+
+// Picks the widest instruction set the target is built for. The kernels using it keep a scalar fallback,
+// so defining none of these is fine.
+#if defined(__AVX__)
+    #include <immintrin.h>
+    #define HD_HAPTICS_SIMD_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define HD_HAPTICS_SIMD_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    #include <arm_neon.h>
+    #define HD_HAPTICS_SIMD_NEON
+#endif